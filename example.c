@@ -3,7 +3,10 @@
  * Ordnance Survey grid references.
  *
  * Compilation:
- *   gcc -std=c99 -lm *.c
+ *   make
+ *
+ * Or, without make (only building the baseline transform kernels):
+ *   gcc -std=c99 *.c -lm
  *
  * Usage:
  *   ./a.out [lat] [lon] [height]
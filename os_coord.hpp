@@ -0,0 +1,426 @@
+/**
+ * OS Coord: A Simple OS Coordinate Transformation Library for C
+ *
+ * This is a port of a the Javascript library produced by Chris Veness available
+ * from http://www.movable-type.co.uk/scripts/latlong-gridref.html.
+ *
+ * A header-only C++20 version of the conversions in os_coord_transform.c. The
+ * ellipsoid, Helmert and projection parameters are template parameters and so
+ * everything derived from them is computed at compile time and whole
+ * conversion pipelines may be inlined into the caller. Results agree with the
+ * C functions to within nanometres: they are identical to the C library's
+ * baseline kernels but the AVX2 and AVX-512 kernels chosen on most CPUs fuse
+ * multiplies and adds (see os_transform_isa), which changes the last few bits.
+ *
+ * For example, to convert a batch of WGS84 points into National Grid eastings
+ * and northings (in parallel):
+ *
+ *   std::vector<os_lat_lon_t> in = ...;
+ *   std::vector<os_eas_nor_t> out(in.size());
+ *   os_coord::convert<os_coord::wgs84_to_national_grid>(std::execution::par_unseq,
+ *                                                       in, out);
+ *
+ * Parallel execution requires a standard library with parallel algorithm
+ * support (e.g. for GCC, linking against TBB).
+ */
+
+#ifndef OS_COORD_HPP
+#define OS_COORD_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+
+#if __has_include(<execution>)
+#include <execution>
+#endif
+
+#include "os_coord.h"
+#include "os_coord_transform.h"
+
+namespace os_coord {
+
+/******************************************************************************
+ * Parameters. These are the same values as in os_coord_data.h but usable as
+ * template arguments.
+ ******************************************************************************/
+
+inline constexpr os_ellipsoid_t airy_1830 = {.a=6377563.396, .b=6356256.910};
+inline constexpr os_ellipsoid_t airy_1830_modified = {.a=6377340.189, .b=6356034.447};
+inline constexpr os_ellipsoid_t international_1924 = {.a=6378388.000, .b=6356911.946};
+inline constexpr os_ellipsoid_t wgs84 = {.a=6378137.000, .b=6356752.3141};
+
+inline constexpr os_helmert_t wgs84_to_osgb36 = {
+	.tx= -446.448,  .ty=  125.157,   .tz= -542.060,
+	.rx=   -0.1502, .ry=   -0.2470,  .rz=   -0.8421,
+	 .s=   20.4894
+};
+
+inline constexpr os_helmert_t wgs84_to_ed50 = {
+	.tx= 89.5, .ty= 93.8, .tz= 123.1,
+	.rx=  0.0, .ry=  0.0, .rz=   0.156,
+	 .s= -1.2
+};
+
+inline constexpr os_helmert_t etrf89_to_irl1975 = {
+	.tx= -482.530, .ty= 130.596, .tz= -564.557,
+	.rx=   -1.042, .ry=  -0.214, .rz=   -0.631,
+	 .s=   -8.150
+};
+
+inline constexpr os_tm_projection_t national_grid = {
+	.e0=400000.0, .n0=-100000.0,
+	.f0=0.9996012717,
+	.lat0=49.0, .lon0=-2.0,
+	.ellipsoid=airy_1830
+};
+
+inline constexpr os_tm_projection_t irish_national_grid = {
+	.e0=200000.0, .n0=250000.0,
+	.f0=1.000035,
+	.lat0=53.5, .lon0=-8.0,
+	.ellipsoid=airy_1830_modified
+};
+
+
+/******************************************************************************
+ * Values derived from the parameters (computed at compile time).
+ ******************************************************************************/
+
+namespace detail {
+
+constexpr double pi = 3.141592653589793;
+
+constexpr double deg_2_rad(double deg) { return ((deg)/180) * pi; }
+
+/**
+ * Eccentricity squared.
+ */
+constexpr double
+e_sq(os_ellipsoid_t ellipsoid)
+{
+	return ((ellipsoid.a*ellipsoid.a) - (ellipsoid.b*ellipsoid.b))
+	       / (ellipsoid.a*ellipsoid.a);
+}
+
+/**
+ * Helmert parameters normalised to radians and (1+s).
+ */
+struct helmert_constants {
+	double rx, ry, rz, s1;
+	
+	constexpr explicit helmert_constants(os_helmert_t helmert)
+		: rx(deg_2_rad(helmert.rx/3600.0))
+		, ry(deg_2_rad(helmert.ry/3600.0))
+		, rz(deg_2_rad(helmert.rz/3600.0))
+		, s1(1+ (helmert.s/1000000.0))
+	{}
+};
+
+/**
+ * Point-independent parts of the transverse mercator projection.
+ */
+struct tm_constants {
+	double lat0, lon0;
+	double e2;
+	double af0, af0e2, bf0;
+	double cMa, cMb, cMc, cMd;
+	
+	constexpr explicit tm_constants(os_tm_projection_t projection)
+		: lat0(deg_2_rad(projection.lat0))
+		, lon0(deg_2_rad(projection.lon0))
+		, e2(0), af0(0), af0e2(0), bf0(0), cMa(0), cMb(0), cMc(0), cMd(0)
+	{
+		double a = projection.ellipsoid.a;
+		double b = projection.ellipsoid.b;
+		e2 = 1.0 - (b*b)/(a*a);
+		double n = (a-b)/(a+b);
+		double n2 = n*n;
+		double n3 = n*n*n;
+		af0 = a*projection.f0;
+		af0e2 = a*projection.f0*(1.0-e2);
+		bf0 = b*projection.f0;
+		cMa = 1.0 + n + (5.0/4.0)*n2 + (5.0/4.0)*n3;
+		cMb = 3.0*n + 3.0*n*n + (21.0/8.0)*n3;
+		cMc = (15.0/8.0)*n2 + (15.0/8.0)*n3;
+		cMd = (35.0/24.0)*n3;
+	}
+};
+
+/**
+ * Meridional arc.
+ */
+inline double
+meridional_arc(const tm_constants &c, double lat)
+{
+	double Ma = c.cMa * (lat-c.lat0);
+	double Mb = c.cMb * std::sin(lat-c.lat0) * std::cos(lat+c.lat0);
+	double Mc = c.cMc * std::sin(2.0*(lat-c.lat0)) * std::cos(2.0*(lat+c.lat0));
+	double Md = c.cMd * std::sin(3.0*(lat-c.lat0)) * std::cos(3.0*(lat+c.lat0));
+	return c.bf0 * (Ma - Mb + Mc - Md);
+}
+
+/**
+ * Argument and result types of a single-point conversion function.
+ */
+template <class Fn> struct conversion_traits;
+template <class Out, class In> struct conversion_traits<Out (*)(In)> {
+	using in_type = std::remove_cvref_t<In>;
+	using out_type = Out;
+};
+
+template <auto Fn>
+using in_t = typename conversion_traits<decltype(Fn)>::in_type;
+
+template <auto Fn>
+using out_t = typename conversion_traits<decltype(Fn)>::out_type;
+
+}  // namespace detail
+
+
+/******************************************************************************
+ * Single-point conversions. See os_coord_transform.h.
+ ******************************************************************************/
+
+template <os_ellipsoid_t Ellipsoid>
+inline os_cartesian_t
+lat_lon_to_cartesian(os_lat_lon_t point)
+{
+	constexpr double eSq = detail::e_sq(Ellipsoid);
+	
+	double sinPhi = std::sin(point.lat);
+	double cosPhi = std::cos(point.lat);
+	double sinLambda = std::sin(point.lon);
+	double cosLambda = std::cos(point.lon);
+	
+	double nu = Ellipsoid.a / std::sqrt(1.0 - (eSq*(sinPhi*sinPhi)));
+	
+	os_cartesian_t cart_point;
+	cart_point.x = (nu+point.eh) * cosPhi * cosLambda;
+	cart_point.y = (nu+point.eh) * cosPhi * sinLambda;
+	cart_point.z = ((1.0-eSq)*nu + point.eh) * sinPhi;
+	
+	return cart_point;
+}
+
+
+template <os_ellipsoid_t Ellipsoid>
+inline os_lat_lon_t
+cartesian_to_lat_lon(os_cartesian_t point)
+{
+	// results accurate to around the given number of metres
+	constexpr double precision = OS_CART_TO_LAT_LON_PRECISION / Ellipsoid.a;
+	constexpr double eSq = detail::e_sq(Ellipsoid);
+	
+	double p = std::sqrt((point.x*point.x) + (point.y*point.y));
+	double phi  = std::atan2(point.z, p*(1.0-eSq));
+	double phiP = 2.0*detail::pi;
+	double nu = 0.0;
+	while (std::fabs(phi-phiP) > precision) {
+	  nu   = Ellipsoid.a / std::sqrt(1.0 - eSq*(std::sin(phi)*std::sin(phi)));
+	  phiP = phi;
+	  phi  = std::atan2(point.z + eSq*nu*std::sin(phi), p);
+	}
+	
+	os_lat_lon_t lat_lon;
+	lat_lon.lat = phi;
+	lat_lon.lon = std::atan2(point.y, point.x);
+	lat_lon.eh  = p/std::cos(phi) - nu;
+	
+	return lat_lon;
+}
+
+
+template <os_helmert_t Helmert>
+inline os_cartesian_t
+helmert_transform(os_cartesian_t point)
+{
+	constexpr detail::helmert_constants c(Helmert);
+	
+	os_cartesian_t new_point;
+	new_point.x = Helmert.tx + point.x*c.s1 - point.y*c.rz + point.z*c.ry;
+	new_point.y = Helmert.ty + point.x*c.rz + point.y*c.s1 - point.z*c.rx;
+	new_point.z = Helmert.tz - point.x*c.ry + point.y*c.rx + point.z*c.s1;
+	
+	return new_point;
+}
+
+
+template <os_tm_projection_t Projection>
+inline os_eas_nor_t
+lat_lon_to_tm_eas_nor(os_lat_lon_t point)
+{
+	constexpr detail::tm_constants c(Projection);
+	
+	double lat = point.lat;
+	double lon = point.lon;
+	
+	double cosLat = std::cos(lat);
+	double sinLat = std::sin(lat);
+	
+	// Transverse radius of curvature
+	double nu = c.af0/std::sqrt(1.0-c.e2*sinLat*sinLat);
+	// Meridional radius of curvature
+	double rho = c.af0e2/std::pow(1.0-c.e2*sinLat*sinLat, 1.5);
+	double eta2 = nu/rho-1.0;
+	
+	double M = detail::meridional_arc(c, lat);
+	
+	double cos3lat = cosLat*cosLat*cosLat;
+	double cos5lat = cos3lat*cosLat*cosLat;
+	double tan2lat = std::tan(lat)*std::tan(lat);
+	double tan4lat = tan2lat*tan2lat;
+	
+	double I = M + Projection.n0;
+	double II = (nu/2.0)*sinLat*cosLat;
+	double III = (nu/24.0)*sinLat*cos3lat*(5.0-tan2lat+9.0*eta2);
+	double IIIA = (nu/720.0)*sinLat*cos5lat*(61.0-58.0*tan2lat+tan4lat);
+	double IV = nu*cosLat;
+	double V = (nu/6.0)*cos3lat*(nu/rho-tan2lat);
+	double VI = (nu/120.0) * cos5lat * (5.0 - 18.0*tan2lat + tan4lat + 14.0*eta2 - 58.0*tan2lat*eta2);
+	
+	double dLon = lon-c.lon0;
+	double dLon2 = dLon*dLon;
+	double dLon3 = dLon2*dLon;
+	double dLon4 = dLon3*dLon;
+	double dLon5 = dLon4*dLon;
+	double dLon6 = dLon5*dLon;
+	
+	os_eas_nor_t eas_nor;
+	eas_nor.n = I + II*dLon2 + III*dLon4 + IIIA*dLon6;
+	eas_nor.e = Projection.e0 + IV*dLon + V*dLon3 + VI*dLon5;
+	eas_nor.h = point.eh;
+	
+	return eas_nor;
+}
+
+
+template <os_tm_projection_t Projection>
+inline os_lat_lon_t
+tm_eas_nor_to_lat_lon(os_eas_nor_t point)
+{
+	constexpr detail::tm_constants c(Projection);
+	
+	double lat=c.lat0;
+	double M=0;
+	do {
+	  lat = (point.n-Projection.n0-M)/c.af0 + lat;
+	  M = detail::meridional_arc(c, lat);
+	} while (std::fabs(point.n-Projection.n0-M) >= OS_EAS_NOR_TO_LAT_LON_PRECISION);
+	
+	double cosLat = std::cos(lat);
+	double sinLat = std::sin(lat);
+	// Transverse radius of curvature
+	double nu = c.af0/std::sqrt(1.0-c.e2*sinLat*sinLat);
+	// Meridional radius of curvature
+	double rho = c.af0e2/std::pow(1.0-c.e2*sinLat*sinLat, 1.5);
+	double eta2 = nu/rho-1.0;
+	
+	double tanLat = std::tan(lat);
+	double tan2lat = tanLat*tanLat;
+	double tan4lat = tan2lat*tan2lat;
+	double tan6lat = tan4lat*tan2lat;
+	double secLat = 1.0/cosLat;
+	double nu3 = nu*nu*nu;
+	double nu5 = nu3*nu*nu;
+	double nu7 = nu5*nu*nu;
+	double VII = tanLat/(2.0*rho*nu);
+	double VIII = tanLat/(24.0*rho*nu3)*(5.0+3.0*tan2lat+eta2-9.0*tan2lat*eta2);
+	double IX = tanLat/(720.0*rho*nu5)*(61.0+90.0*tan2lat+45.0*tan4lat);
+	double X = secLat/nu;
+	double XI = secLat/(6.0*nu3)*(nu/rho+2.0*tan2lat);
+	double XII = secLat/(120.0*nu5)*(5.0+28.0*tan2lat+24.0*tan4lat);
+	double XIIA = secLat/(5040.0*nu7)*(61.0+662.0*tan2lat+1320.0*tan4lat+720.0*tan6lat);
+	
+	double dE = (point.e-Projection.e0);
+	double dE2 = dE*dE;
+	double dE3 = dE2*dE;
+	double dE4 = dE2*dE2;
+	double dE5 = dE3*dE2;
+	double dE6 = dE4*dE2;
+	double dE7 = dE5*dE2;
+	
+	os_lat_lon_t lat_lon;
+	
+	lat_lon.lat = lat - VII*dE2 + VIII*dE4 - IX*dE6;
+	lat_lon.lon = c.lon0 + X*dE - XI*dE3 + XII*dE5 - XIIA*dE7;
+	lat_lon.eh  = point.h;
+	
+	return lat_lon;
+}
+
+
+/**
+ * Convert a lat/lon/eh on one ellipsoid into eastings and northings on a
+ * projection using a different datum. The point is converted to cartesian
+ * coordinates, Helmert transformed onto the projection's ellipsoid and then
+ * projected.
+ */
+template <os_ellipsoid_t Ellipsoid, os_helmert_t Helmert, os_tm_projection_t Projection>
+inline os_eas_nor_t
+datum_lat_lon_to_tm_eas_nor(os_lat_lon_t point)
+{
+	return lat_lon_to_tm_eas_nor<Projection>(
+	       cartesian_to_lat_lon<Projection.ellipsoid>(
+	       helmert_transform<Helmert>(
+	       lat_lon_to_cartesian<Ellipsoid>(point))));
+}
+
+
+/**
+ * Convert a WGS84 (i.e. GPS) lat/lon/eh into OS National Grid eastings and
+ * northings.
+ */
+inline os_eas_nor_t
+wgs84_to_national_grid(os_lat_lon_t point)
+{
+	return datum_lat_lon_to_tm_eas_nor<wgs84, wgs84_to_osgb36, national_grid>(point);
+}
+
+
+/******************************************************************************
+ * Batch conversions.
+ ******************************************************************************/
+
+/**
+ * Apply a single-point conversion function (such as those above) to every
+ * point of in, writing the results into out which must be at least as long.
+ */
+template <auto Fn>
+inline void
+convert( std::span<const detail::in_t<Fn>> in
+       , std::span<detail::out_t<Fn>>      out
+       )
+{
+	for (std::size_t i = 0; i < in.size(); i++) {
+		out[i] = Fn(in[i]);
+	}
+}
+
+
+#ifdef __cpp_lib_execution
+/**
+ * As above but using the given execution policy (e.g.
+ * std::execution::par_unseq).
+ */
+template <auto Fn, class ExecutionPolicy>
+requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+inline void
+convert( ExecutionPolicy                   &&policy
+       , std::span<const detail::in_t<Fn>>   in
+       , std::span<detail::out_t<Fn>>        out
+       )
+{
+	std::transform( std::forward<ExecutionPolicy>(policy)
+	              , in.begin(), in.end(), out.begin()
+	              , [](const detail::in_t<Fn> &point) { return Fn(point); }
+	              );
+}
+#endif
+
+}  // namespace os_coord
+
+#endif
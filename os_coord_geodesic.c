@@ -0,0 +1,243 @@
+/**
+ * OS Coord: A Simple OS Coordinate Transformation Library for C
+ *
+ * This is a port of a the Javascript library produced by Chris Veness available
+ * from http://www.movable-type.co.uk/scripts/latlong-gridref.html.
+ *
+ * The ellipsoidal inverse follows T. Vincenty, "Direct and Inverse Solutions
+ * of Geodesics on the Ellipsoid with application of nested equations", Survey
+ * Review, vol XXIII no 176, 1975 (as also ported from Chris Veness'
+ * http://www.movable-type.co.uk/scripts/latlong-vincenty.html). The grid
+ * distance scale factors are from "A guide to coordinate systems in Great
+ * Britain", Annex C.
+ */
+
+#include <stddef.h>
+#include <math.h>
+
+#include "os_coord.h"
+#include "os_coord_math.h"
+#include "os_coord_geodesic.h"
+
+/**
+ * Normalise a bearing into the range [0, 2*PI).
+ */
+static double
+normalise_bearing(double bearing)
+{
+	bearing = fmod(bearing, 2.0*PI);
+	return (bearing < 0.0) ? bearing + 2.0*PI : bearing;
+}
+
+
+os_geodesic_t
+os_lat_lon_geodesic( os_lat_lon_t   from
+                   , os_lat_lon_t   to
+                   , os_ellipsoid_t ellipsoid
+                   )
+{
+	os_geodesic_t geodesic;
+	os_lat_lon_geodesic_batch(&from, &to, &geodesic, 1, ellipsoid);
+	return geodesic;
+}
+
+
+void
+os_lat_lon_geodesic_batch( const os_lat_lon_t *from
+                         , const os_lat_lon_t *to
+                         , os_geodesic_t      *geodesics
+                         , size_t              num_points
+                         , os_ellipsoid_t      ellipsoid
+                         )
+{
+	double a = ellipsoid.a;
+	double b = ellipsoid.b;
+	double f = (a-b)/a;
+	
+	for (size_t i = 0; i < num_points; i++) {
+		double L = to[i].lon - from[i].lon;
+	
+		// Reduced latitudes
+		double tanU1 = (1.0-f) * tan(from[i].lat);
+		double cosU1 = 1.0 / sqrt(1.0 + tanU1*tanU1);
+		double sinU1 = tanU1 * cosU1;
+		double tanU2 = (1.0-f) * tan(to[i].lat);
+		double cosU2 = 1.0 / sqrt(1.0 + tanU2*tanU2);
+		double sinU2 = tanU2 * cosU2;
+	
+		double lambda = L;
+		double lambdaP;
+		double sinLambda, cosLambda;
+		double sinSigma = 0.0, cosSigma = 1.0, sigma = 0.0;
+		double cosSqAlpha = 1.0, cos2SigmaM = 0.0;
+		int iterations = 0;
+		do {
+		  sinLambda = sin(lambda);
+		  cosLambda = cos(lambda);
+		  double sinSqSigma = (cosU2*sinLambda) * (cosU2*sinLambda)
+		                      + (cosU1*sinU2-sinU1*cosU2*cosLambda)
+		                        * (cosU1*sinU2-sinU1*cosU2*cosLambda);
+		  sinSigma = sqrt(sinSqSigma);
+		  if (sinSigma == 0.0) {
+		    // Coincident points
+		    break;
+		  }
+		  cosSigma = sinU1*sinU2 + cosU1*cosU2*cosLambda;
+		  sigma = atan2(sinSigma, cosSigma);
+		  double sinAlpha = cosU1 * cosU2 * sinLambda / sinSigma;
+		  cosSqAlpha = 1.0 - sinAlpha*sinAlpha;
+		  // Lines along the equator have cosSqAlpha = 0
+		  cos2SigmaM = (cosSqAlpha != 0.0) ? cosSigma - 2.0*sinU1*sinU2/cosSqAlpha : 0.0;
+		  double C = f/16.0*cosSqAlpha*(4.0+f*(4.0-3.0*cosSqAlpha));
+		  lambdaP = lambda;
+		  lambda = L + (1.0-C) * f * sinAlpha
+		           * (sigma + C*sinSigma*(cos2SigmaM+C*cosSigma*(-1.0+2.0*cos2SigmaM*cos2SigmaM)));
+		} while (fabs(lambda-lambdaP) > OS_GEODESIC_PRECISION
+		         && ++iterations < OS_GEODESIC_MAX_ITERATIONS);
+	
+		os_geodesic_t geodesic;
+	
+		if (sinSigma == 0.0) {
+			geodesic.distance = 0.0;
+			geodesic.initial_bearing = 0.0;
+			geodesic.final_bearing = 0.0;
+		} else if (iterations >= OS_GEODESIC_MAX_ITERATIONS) {
+			// Failed to converge (nearly antipodal points)
+			geodesic.distance = NAN;
+			geodesic.initial_bearing = NAN;
+			geodesic.final_bearing = NAN;
+		} else {
+			double uSq = cosSqAlpha * (a*a - b*b) / (b*b);
+			double A = 1.0 + uSq/16384.0*(4096.0+uSq*(-768.0+uSq*(320.0-175.0*uSq)));
+			double B = uSq/1024.0 * (256.0+uSq*(-128.0+uSq*(74.0-47.0*uSq)));
+			double deltaSigma = B*sinSigma*(cos2SigmaM+B/4.0*(cosSigma*(-1.0+2.0*cos2SigmaM*cos2SigmaM)
+			                    - B/6.0*cos2SigmaM*(-3.0+4.0*sinSigma*sinSigma)*(-3.0+4.0*cos2SigmaM*cos2SigmaM)));
+	
+			geodesic.distance = b*A*(sigma-deltaSigma);
+			geodesic.initial_bearing = normalise_bearing(
+				atan2(cosU2*sinLambda, cosU1*sinU2-sinU1*cosU2*cosLambda));
+			geodesic.final_bearing = normalise_bearing(
+				atan2(cosU1*sinLambda, -sinU1*cosU2+cosU1*sinU2*cosLambda));
+		}
+	
+		geodesics[i] = geodesic;
+	}
+}
+
+
+os_geodesic_t
+os_tm_eas_nor_geodesic( os_eas_nor_t       from
+                      , os_eas_nor_t       to
+                      , os_tm_projection_t projection
+                      )
+{
+	os_geodesic_t geodesic;
+	os_tm_eas_nor_geodesic_batch(&from, &to, &geodesic, 1, projection);
+	return geodesic;
+}
+
+
+void
+os_tm_eas_nor_geodesic_batch( const os_eas_nor_t *from
+                            , const os_eas_nor_t *to
+                            , os_geodesic_t      *geodesics
+                            , size_t              num_points
+                            , os_tm_projection_t  projection
+                            )
+{
+	double lat0 = DEG_2_RAD(projection.lat0);
+	
+	// Shorter-named alias
+	double a = projection.ellipsoid.a;
+	double b = projection.ellipsoid.b;
+	double f0 = projection.f0;
+	
+	double e2 = 1.0 - (b*b)/(a*a);
+	
+	double n = (a-b)/(a+b);
+	double n2 = n*n;
+	double n3 = n*n*n;
+	
+	double n4 = n2*n2;
+	
+	// Meridional arc from the equator to the true origin (as in
+	// os_lat_lon_to_tm_eas_nor but without the scale factor)
+	double cMa = 1.0 + n + (5.0/4.0)*n2 + (5.0/4.0)*n3;
+	double cMb = 3.0*n + 3.0*n*n + (21.0/8.0)*n3;
+	double cMc = (15.0/8.0)*n2 + (15.0/8.0)*n3;
+	double cMd = (35.0/24.0)*n3;
+	double M0 = b * ( (cMa * lat0)
+	                - (cMb * sin(lat0) * cos(lat0))
+	                + (cMc * sin(2.0*lat0) * cos(2.0*lat0))
+	                - (cMd * sin(3.0*lat0) * cos(3.0*lat0))
+	                );
+	
+	// Rectifying radius and coefficients of the series giving latitude from
+	// the rectifying latitude.
+	double A = a/(1.0+n) * (1.0 + n2/4.0 + n4/64.0);
+	double c2mu = (3.0/2.0)*n - (27.0/32.0)*n3;
+	double c4mu = (21.0/16.0)*n2 - (55.0/32.0)*n4;
+	double c6mu = (151.0/96.0)*n3;
+	
+	for (size_t i = 0; i < num_points; i++) {
+		double E1 = from[i].e - projection.e0;
+		double E2 = to[i].e - projection.e0;
+		double dE = to[i].e - from[i].e;
+		double dN = to[i].n - from[i].n;
+		double grid_distance = sqrt(dE*dE + dN*dN);
+		
+		// Footpoint latitude of the mid-point of the line (the latitude at which
+		// the meridional arc equals the northings) from the rectifying latitude.
+		double mu = (((0.5*(from[i].n + to[i].n)) - projection.n0)/f0 + M0) / A;
+		double sin2mu = sin(2.0*mu);
+		double cos2mu = cos(2.0*mu);
+		double lat = mu + (c2mu * sin2mu)
+		                + (c4mu * 2.0*sin2mu*cos2mu)
+		                + (c6mu * sin2mu*(3.0 - 4.0*sin2mu*sin2mu));
+		
+		double sinLat = sin(lat);
+		double cosLat = cos(lat);
+		double w = 1.0 - e2*sinLat*sinLat;
+		// Transverse and meridional radii of curvature (scaled by f0)
+		double nu = a*f0/sqrt(w);
+		double rho = a*f0*(1.0-e2)/(w*sqrt(w));
+		double eta2 = nu/rho-1.0;
+		
+		// Line scale factor: the point scale factor f0*(1 + E^2/(2*rho*nu))
+		// integrated along the line using Simpson's rule (exact since it is
+		// quadratic in E).
+		double F = f0 * (1.0 + (E1*E1 + E1*E2 + E2*E2) / (6.0*rho*nu));
+		
+		os_geodesic_t geodesic;
+		geodesic.distance = grid_distance / F;
+		
+		if (grid_distance == 0.0) {
+			geodesic.initial_bearing = 0.0;
+			geodesic.final_bearing = 0.0;
+		} else {
+			// Grid bearing of the straight line between the points
+			double t = atan2(dE, dN);
+			
+			// Angle between the straight line and the (curved) projection of the
+			// geodesic at each end in the direction of travel ("t - T").
+			double tT1 = -(2.0*E1 + E2) * dN / (6.0*rho*nu);
+			double tT2 =  (2.0*E2 + E1) * dN / (6.0*rho*nu);
+			
+			// Meridian convergence at each end. The footpoint latitudes of the ends
+			// differ from the mid-point's by a small angle, d, so tan(d) ~= d.
+			double tanLat = sinLat/cosLat;
+			double d = 0.5*dN/rho;
+			double tan1 = (tanLat - d) / (1.0 + tanLat*d);
+			double tan2 = (tanLat + d) / (1.0 - tanLat*d);
+			double c1 = (E1*tan1/nu)
+			            - (E1*E1*E1*tan1/(3.0*nu*nu*nu))*(1.0 + tan1*tan1 - eta2);
+			double c2 = (E2*tan2/nu)
+			            - (E2*E2*E2*tan2/(3.0*nu*nu*nu))*(1.0 + tan2*tan2 - eta2);
+			
+			geodesic.initial_bearing = normalise_bearing(t - tT1 + c1);
+			geodesic.final_bearing = normalise_bearing(t - tT2 + c2);
+		}
+		
+		geodesics[i] = geodesic;
+	}
+}
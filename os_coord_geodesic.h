@@ -0,0 +1,103 @@
+/**
+ * OS Coord: A Simple OS Coordinate Transformation Library for C
+ *
+ * This is a port of a the Javascript library produced by Chris Veness available
+ * from http://www.movable-type.co.uk/scripts/latlong-gridref.html.
+ *
+ * Distances and bearings between pairs of points on an ellipsoid.
+ */
+
+#ifndef OS_COORD_GEODESIC_H
+#define OS_COORD_GEODESIC_H
+
+#include <stddef.h>
+
+#include "os_coord.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Vincenty's inverse formula iterates until the change in longitude on the
+ * auxiliary sphere is smaller than this (radians). 1e-12 corresponds to around
+ * 0.006mm.
+ */
+#define OS_GEODESIC_PRECISION 1e-12
+
+/**
+ * Maximum number of iterations of Vincenty's inverse formula. Nearly antipodal
+ * points fail to converge in this many iterations.
+ */
+#define OS_GEODESIC_MAX_ITERATIONS 200
+
+/**
+ * The geodesic (shortest path over the ellipsoid) between two points.
+ */
+typedef struct os_geodesic {
+	// Length of the geodesic (m)
+	double distance;
+	
+	// Bearing (radians clockwise from true north, 0 to 2*PI) of the geodesic at
+	// the starting point.
+	double initial_bearing;
+	
+	// Bearing (radians clockwise from true north, 0 to 2*PI) of the direction of
+	// travel along the geodesic on arrival at the end point.
+	double final_bearing;
+} os_geodesic_t;
+
+
+/**
+ * Find the geodesic between two lat/lon points on an ellipsoid using
+ * Vincenty's inverse formula. Ellipsoidal heights are ignored.
+ *
+ * The result is accurate to well under a millimetre. If the points are nearly
+ * antipodal and the formula does not converge, all fields are NaN. Coincident
+ * points have a distance and bearings of zero.
+ */
+os_geodesic_t os_lat_lon_geodesic(os_lat_lon_t from, os_lat_lon_t to, os_ellipsoid_t ellipsoid);
+
+void os_lat_lon_geodesic_batch( const os_lat_lon_t *from
+                              , const os_lat_lon_t *to
+                              , os_geodesic_t      *geodesics
+                              , size_t              num_points
+                              , os_ellipsoid_t      ellipsoid
+                              );
+
+/**
+ * Find the geodesic between two points given as eastings and northings on a
+ * transverse mercator projection without converting them back to lat/lon
+ * (which is around three times faster than os_lat_lon_geodesic). Heights are
+ * ignored.
+ *
+ * The distance is the grid distance divided by the line scale factor (derived
+ * from the projection's central meridian scale factor, f0). The bearings are
+ * the grid bearing corrected for the curvature of the projected line and the
+ * meridian convergence at each end.
+ *
+ * Compared with os_lat_lon_geodesic on the National Grid, for points within
+ * Great Britain (up to 300km from the central meridian):
+ *
+ *   - The distance is within 1 part per million.
+ *   - The bearings are within 0.5 arc-seconds for lines of up to 10km and
+ *     within 1.5 arc-seconds for lines of up to 100km.
+ *
+ * The errors grow rapidly with distance from the central meridian and so
+ * os_lat_lon_geodesic should be used for points far outside the area the
+ * projection is designed for.
+ */
+os_geodesic_t os_tm_eas_nor_geodesic(os_eas_nor_t from, os_eas_nor_t to, os_tm_projection_t projection);
+
+void os_tm_eas_nor_geodesic_batch( const os_eas_nor_t *from
+                                 , const os_eas_nor_t *to
+                                 , os_geodesic_t      *geodesics
+                                 , size_t              num_points
+                                 , os_tm_projection_t  projection
+                                 );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,488 @@
+/**
+ * OS Coord: A Simple OS Coordinate Transformation Library for C
+ *
+ * This is a port of a the Javascript library produced by Chris Veness available
+ * from http://www.movable-type.co.uk/scripts/latlong-gridref.html.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "os_coord.h"
+#include "os_coord_math.h"
+#include "os_coord_transform.h"
+#include "os_coord_geojson.h"
+
+/**
+ * Is the character a decimal digit.
+ */
+#define IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+
+/**
+ * Can the character start a JSON number.
+ */
+#define IS_NUMBER_START(c) (IS_DIGIT(c) || (c) == '-')
+
+/**
+ * Can the character appear in a JSON number.
+ */
+#define IS_NUMBER_CHAR(c) (IS_NUMBER_START(c) || (c) == '.' || (c) == 'e' \
+                           || (c) == 'E' || (c) == '+')
+
+/**
+ * Is the character JSON whitespace.
+ */
+#define IS_WHITESPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+
+/**
+ * The key whose value holds positions.
+ */
+#define COORDINATES_KEY "coordinates"
+
+/**
+ * Number of significant digits of a number which are used when parsing it.
+ * Further digits only affect the value beyond the precision of a double.
+ */
+#define MAX_SIGNIFICANT_DIGITS 19
+
+/**
+ * Largest magnitude which is written out (chosen so that the value in units of
+ * the last decimal place is well within the integer range of a double). Larger
+ * (or non-finite) results leave the position unchanged.
+ */
+#define MAX_OUTPUT_MAGNITUDE 1e12
+
+/**
+ * Exactly representable powers of ten.
+ */
+static const double POW10[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+#define MAX_EXACT_POW10 ((int)(sizeof(POW10)/sizeof(POW10[0])) - 1)
+
+
+/**
+ * Write some output, recording an error on failure.
+ */
+static int
+emit( os_geojson_reprojector_t *r
+    , const char               *data
+    , size_t                    length
+    )
+{
+	if (length > 0 && r->write(r->context, data, length) != length) {
+		r->error = 1;
+	}
+	return !r->error;
+}
+
+
+/**
+ * Scale a value by a power of ten.
+ */
+static double
+scale_pow10(double value, int exponent)
+{
+	if (exponent >= 0) {
+		return value * ((exponent <= MAX_EXACT_POW10) ? POW10[exponent] : pow(10.0, exponent));
+	} else {
+		return value / ((-exponent <= MAX_EXACT_POW10) ? POW10[-exponent] : pow(10.0, -exponent));
+	}
+}
+
+
+/**
+ * Parse a value of a position in the buffer as a JSON number (independent of
+ * the C locale). Returns 0 if it is not a valid JSON number or is too large to
+ * represent.
+ */
+static int
+parse_value( const os_geojson_reprojector_t *r
+           , const os_geojson_position_t    *position
+           , int                             value
+           , double                         *result
+           )
+{
+	const char *c = r->buffer + position->start[value];
+	const char *end = r->buffer + position->end[value];
+	
+	int negative = (c < end && *c == '-');
+	c += negative;
+	
+	// Significant digits and the power of ten they are to be scaled by
+	uint64_t mantissa = 0;
+	int num_digits = 0;
+	int exponent = 0;
+	
+	// Integer part (a single zero or digits not starting with zero)
+	if (c == end || !IS_DIGIT(*c) || (*c == '0' && c + 1 < end && IS_DIGIT(c[1]))) {
+		return 0;
+	}
+	for (; c < end && IS_DIGIT(*c); c++) {
+		if (num_digits < MAX_SIGNIFICANT_DIGITS) {
+			mantissa = (mantissa * 10) + (uint64_t)(*c - '0');
+			num_digits += (mantissa != 0);
+		} else {
+			exponent++;
+		}
+	}
+	
+	// Fractional part
+	if (c < end && *c == '.') {
+		c++;
+		if (c == end || !IS_DIGIT(*c)) {
+			return 0;
+		}
+		for (; c < end && IS_DIGIT(*c); c++) {
+			if (num_digits < MAX_SIGNIFICANT_DIGITS) {
+				mantissa = (mantissa * 10) + (uint64_t)(*c - '0');
+				num_digits += (mantissa != 0);
+				exponent--;
+			}
+		}
+	}
+	
+	// Exponent
+	if (c < end && (*c == 'e' || *c == 'E')) {
+		c++;
+		int exp_negative = (c < end && *c == '-');
+		if (c < end && (*c == '-' || *c == '+')) {
+			c++;
+		}
+		if (c == end || !IS_DIGIT(*c)) {
+			return 0;
+		}
+		int exp = 0;
+		for (; c < end && IS_DIGIT(*c); c++) {
+			// Anything this large over- or underflows anyway
+			if (exp < 10000) {
+				exp = (exp * 10) + (*c - '0');
+			}
+		}
+		exponent += exp_negative ? -exp : exp;
+	}
+	
+	if (c != end) {
+		return 0;
+	}
+	
+	double magnitude = scale_pow10((double)mantissa, exponent);
+	if (!isfinite(magnitude)) {
+		return 0;
+	}
+	*result = negative ? -magnitude : magnitude;
+	return 1;
+}
+
+
+/**
+ * Write a value with OS_GEOJSON_DECIMAL_PLACES decimal places (independent of
+ * the C locale). Returns the number of characters written, or 0 if the value
+ * is not finite or too large to write.
+ */
+static size_t
+format_value(double value, char *number)
+{
+	if (!(fabs(value) < MAX_OUTPUT_MAGNITUDE)) {
+		return 0;
+	}
+	
+	// The value as an integer number of units of the last decimal place,
+	// rounded (half to even) as printf would from the exact product (the rounded
+	// product plus its rounding error).
+	double scale = POW10[OS_GEOJSON_DECIMAL_PLACES];
+	double product = value * scale;
+	double error = fma(value, scale, -product);
+	double whole = floor(product);
+	double fraction = product - whole;
+	if (fraction > 0.5
+	    || (fraction == 0.5 && (error > 0.0
+	                            || (error == 0.0 && fmod(whole, 2.0) != 0.0)))) {
+		whole += 1.0;
+	}
+	int64_t units = (int64_t)whole;
+	uint64_t magnitude = (uint64_t)((units < 0) ? -units : units);
+	
+	// Write the digits backwards, padding to at least one integer digit
+	char digits[32];
+	size_t num_digits = 0;
+	do {
+		digits[num_digits++] = (char)('0' + (magnitude % 10));
+		magnitude /= 10;
+	} while (magnitude != 0 || num_digits <= OS_GEOJSON_DECIMAL_PLACES);
+	
+	size_t length = 0;
+	if (units < 0) {
+		number[length++] = '-';
+	}
+	while (num_digits > 0) {
+		if (num_digits == OS_GEOJSON_DECIMAL_PLACES) {
+			number[length++] = '.';
+		}
+		number[length++] = digits[--num_digits];
+	}
+	return length;
+}
+
+
+/**
+ * Convert all complete positions in the buffer and write out the buffer up to
+ * (but not including) any partially read position. If final is non-zero the
+ * whole buffer is written.
+ */
+static int
+flush(os_geojson_reprojector_t *r, int final)
+{
+	// Find the start of anything which must be kept for the next flush
+	size_t keep = r->length;
+	if (!final) {
+		if (r->position.num_values > 0 && r->position.start[0] < keep) {
+			keep = r->position.start[0];
+		}
+		if (r->in_number && r->number_start < keep) {
+			keep = r->number_start;
+		}
+	}
+	
+	// Convert the complete positions
+	os_lat_lon_t   lat_lons[OS_GEOJSON_BATCH_SIZE];
+	os_cartesian_t carts[OS_GEOJSON_BATCH_SIZE];
+	os_eas_nor_t   eas_nors[OS_GEOJSON_BATCH_SIZE];
+	int            valid[OS_GEOJSON_BATCH_SIZE];
+	for (size_t i = 0; i < r->num_positions; i++) {
+		const os_geojson_position_t *position = &r->positions[i];
+		double lon, lat, h = 0.0;
+		valid[i] = parse_value(r, position, 0, &lon)
+		           && parse_value(r, position, 1, &lat)
+		           && (position->num_values < 3 || parse_value(r, position, 2, &h));
+		lat_lons[i].lat = valid[i] ? DEG_2_RAD(lat) : 0.0;
+		lat_lons[i].lon = valid[i] ? DEG_2_RAD(lon) : 0.0;
+		lat_lons[i].eh  = h;
+	}
+	os_lat_lon_to_cartesian_batch(lat_lons, carts, r->num_positions, r->ellipsoid);
+	os_helmert_transform_batch(carts, carts, r->num_positions, r->helmert);
+	os_cartesian_to_lat_lon_batch(carts, lat_lons, r->num_positions, r->projection.ellipsoid);
+	os_lat_lon_to_tm_eas_nor_batch(lat_lons, eas_nors, r->num_positions, r->projection);
+	
+	// Write out the buffer, substituting the converted values. Positions which
+	// could not be parsed or did not convert to finite values are left as they
+	// are.
+	size_t offset = 0;
+	for (size_t i = 0; i < r->num_positions; i++) {
+		const os_geojson_position_t *position = &r->positions[i];
+		if (!valid[i]) {
+			continue;
+		}
+	
+		double values[3] = {eas_nors[i].e, eas_nors[i].n, eas_nors[i].h};
+		int num_values = (position->num_values < 3) ? position->num_values : 3;
+		char numbers[3][32];
+		size_t lengths[3];
+		int formatted = 1;
+		for (int v = 0; v < num_values && formatted; v++) {
+			lengths[v] = format_value(values[v], numbers[v]);
+			formatted = lengths[v] > 0;
+		}
+		if (!formatted) {
+			continue;
+		}
+	
+		for (int v = 0; v < num_values; v++) {
+			if (!emit(r, r->buffer + offset, position->start[v] - offset)
+			    || !emit(r, numbers[v], lengths[v])) {
+				return 0;
+			}
+			offset = position->end[v];
+		}
+	}
+	r->num_positions = 0;
+	if (!emit(r, r->buffer + offset, keep - offset)) {
+		return 0;
+	}
+	
+	// Move anything kept to the start of the buffer
+	memmove(r->buffer, r->buffer + keep, r->length - keep);
+	r->length -= keep;
+	int num_values = (r->position.num_values < 3) ? r->position.num_values : 3;
+	for (int v = 0; v < num_values; v++) {
+		r->position.start[v] -= keep;
+		r->position.end[v] -= keep;
+	}
+	if (r->in_number) {
+		r->number_start -= keep;
+	}
+	
+	return 1;
+}
+
+
+/**
+ * Record the end of a number at the given buffer offset.
+ */
+static void
+end_number(os_geojson_reprojector_t *r, size_t offset)
+{
+	r->in_number = 0;
+	if (!r->in_coordinates) {
+		return;
+	}
+	
+	if (r->position.num_values < 3) {
+		r->position.start[r->position.num_values] = r->number_start;
+		r->position.end[r->position.num_values] = offset;
+	}
+	if (r->position.num_values <= 3) {
+		r->position.num_values++;
+	}
+}
+
+
+void
+os_geojson_reprojector_init( os_geojson_reprojector_t *r
+                           , os_ellipsoid_t            ellipsoid
+                           , os_helmert_t              helmert
+                           , os_tm_projection_t        projection
+                           , os_geojson_write_t        write
+                           , void                     *context
+                           )
+{
+	memset(r, 0, sizeof(os_geojson_reprojector_t));
+	r->ellipsoid = ellipsoid;
+	r->helmert = helmert;
+	r->projection = projection;
+	r->write = write;
+	r->context = context;
+}
+
+
+int
+os_geojson_reproject( os_geojson_reprojector_t *r
+                    , const char               *data
+                    , size_t                    length
+                    )
+{
+	for (size_t i = 0; i < length && !r->error; i++) {
+		char c = data[i];
+	
+		// Make space in the buffer
+		if (r->length == OS_GEOJSON_BUFFER_SIZE) {
+			if (!flush(r, 0)) {
+				return 0;
+			}
+			if (r->length == OS_GEOJSON_BUFFER_SIZE) {
+				// A single position fills the whole buffer
+				r->error = 1;
+				return 0;
+			}
+		}
+		size_t offset = r->length;
+		r->buffer[r->length++] = c;
+	
+		if (r->in_number && !IS_NUMBER_CHAR(c)) {
+			end_number(r, offset);
+		}
+	
+		if (r->in_string) {
+			// Record (the start of) the string in case it is a key
+			if (r->in_escape) {
+				r->in_escape = 0;
+			} else if (c == '\\') {
+				r->in_escape = 1;
+				r->key_length = sizeof(r->key);
+			} else if (c == '"') {
+				r->in_string = 0;
+				r->after_coordinates_key =
+					r->key_length == strlen(COORDINATES_KEY)
+					&& memcmp(r->key, COORDINATES_KEY, r->key_length) == 0;
+			} else if (r->key_length < sizeof(r->key)) {
+				r->key[r->key_length++] = c;
+			}
+			continue;
+		}
+	
+		if (IS_WHITESPACE(c)) {
+			continue;
+		}
+	
+		// Anything but the expected ':' and '[' means this is not the value of a
+		// "coordinates" key
+		if (c != ':') {
+			r->after_coordinates_key = 0;
+		}
+		if (c != '[') {
+			r->before_coordinates_value = 0;
+		}
+	
+		switch (c) {
+			case '"':
+				r->in_string = 1;
+				r->key_length = 0;
+				break;
+	
+			case ':':
+				r->before_coordinates_value = r->after_coordinates_key;
+				r->after_coordinates_key = 0;
+				break;
+	
+			case '[':
+				if (r->before_coordinates_value && !r->in_coordinates) {
+					r->in_coordinates = 1;
+					r->coordinates_depth = r->depth;
+				}
+				r->before_coordinates_value = 0;
+				r->position.num_values = 0;
+				r->depth++;
+				break;
+	
+			case ']':
+				if (r->in_coordinates && r->position.num_values >= 2) {
+					r->positions[r->num_positions++] = r->position;
+				}
+				r->position.num_values = 0;
+				if (r->num_positions == OS_GEOJSON_BATCH_SIZE && !flush(r, 0)) {
+					return 0;
+				}
+				r->depth--;
+				if (r->in_coordinates && r->depth == r->coordinates_depth) {
+					r->in_coordinates = 0;
+				}
+				break;
+	
+			case '{':
+				r->depth++;
+				break;
+	
+			case '}':
+				r->depth--;
+				break;
+	
+			default:
+				if (r->in_coordinates && !r->in_number && IS_NUMBER_START(c)) {
+					r->in_number = 1;
+					r->number_start = offset;
+				}
+				break;
+		}
+	}
+	
+	return !r->error;
+}
+
+
+int
+os_geojson_reproject_finish(os_geojson_reprojector_t *r)
+{
+	if (r->error || !flush(r, 1)) {
+		return 0;
+	}
+	
+	// The document was truncated
+	if (r->depth != 0 || r->in_string) {
+		r->error = 1;
+		return 0;
+	}
+	
+	return 1;
+}
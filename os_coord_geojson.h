@@ -0,0 +1,154 @@
+/**
+ * OS Coord: A Simple OS Coordinate Transformation Library for C
+ *
+ * This is a port of a the Javascript library produced by Chris Veness available
+ * from http://www.movable-type.co.uk/scripts/latlong-gridref.html.
+ *
+ * Streaming reprojection of GeoJSON documents. The input is tokenised in a
+ * single pass and the positions in every "coordinates" member are converted
+ * in batches and rewritten as eastings, northings (and height) on a transverse
+ * mercator projection. Everything else is copied byte-for-byte. Memory usage is
+ * fixed (see os_geojson_reprojector_t) regardless of the size of the document.
+ * Numbers are read and written independently of the C locale.
+ *
+ * Limitations:
+ *   - Any member named "coordinates" is assumed to hold GeoJSON positions,
+ *     even if it is within a "properties" object.
+ *   - "bbox" members are not rewritten.
+ *   - Only the first three values of each position are converted; any further
+ *     values are copied as-is.
+ *   - Positions which are not valid numbers, or which do not convert to finite
+ *     values (e.g. [1e400, 52]), are copied as-is.
+ */
+
+#ifndef OS_COORD_GEOJSON_H
+#define OS_COORD_GEOJSON_H
+
+#include <stddef.h>
+
+#include "os_coord.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of positions converted at once.
+ */
+#define OS_GEOJSON_BATCH_SIZE 256
+
+/**
+ * Size of the buffer holding input which has not yet been written. A single
+ * position (including any whitespace within it) must fit in this buffer.
+ */
+#define OS_GEOJSON_BUFFER_SIZE 65536
+
+/**
+ * Number of decimal places written for eastings, northings and heights.
+ */
+#define OS_GEOJSON_DECIMAL_PLACES 3
+
+/**
+ * Callback used to write the output. Should return the number of bytes
+ * written; any value other than length is treated as an error.
+ */
+typedef size_t (*os_geojson_write_t)(void *context, const char *data, size_t length);
+
+/**
+ * The location of a position's values in the buffer.
+ */
+typedef struct os_geojson_position {
+	// Number of values found so far (only the first three are recorded)
+	int num_values;
+	
+	// Offset of the first character and one-past-the-last character of each
+	// value in the buffer.
+	size_t start[3];
+	size_t end[3];
+} os_geojson_position_t;
+
+/**
+ * State of a streaming GeoJSON reprojector. Initialise with
+ * os_geojson_reprojector_init.
+ */
+typedef struct os_geojson_reprojector {
+	// Conversion from the input's lat/lon on the given ellipsoid
+	os_ellipsoid_t ellipsoid;
+	os_helmert_t helmert;
+	os_tm_projection_t projection;
+	
+	// Output
+	os_geojson_write_t write;
+	void *context;
+	
+	// Input which has not yet been written
+	char buffer[OS_GEOJSON_BUFFER_SIZE];
+	size_t length;
+	
+	// Complete positions in the buffer waiting to be converted
+	os_geojson_position_t positions[OS_GEOJSON_BATCH_SIZE];
+	size_t num_positions;
+	
+	// The position currently being read
+	os_geojson_position_t position;
+	
+	// Tokeniser state
+	int in_string;
+	int in_escape;
+	int in_number;
+	size_t number_start;
+	char key[12];
+	size_t key_length;
+	int after_coordinates_key;
+	int before_coordinates_value;
+	int in_coordinates;
+	int coordinates_depth;
+	int depth;
+	
+	// Non-zero if an error has occurred
+	int error;
+} os_geojson_reprojector_t;
+
+
+/**
+ * Initialise a reprojector which converts lat/lon (in degrees, as used by
+ * GeoJSON) on the given ellipsoid into eastings and northings on the given
+ * projection using the Helmert transform given. For example, to convert
+ * standard (WGS84) GeoJSON into National Grid eastings and northings use:
+ *
+ *   os_geojson_reprojector_init(&r, OS_EL_WGS84, OS_HE_WGS84_TO_OSGB36,
+ *                               OS_TM_NATIONAL_GRID, write, context);
+ *
+ * The output is passed to write along with the supplied context.
+ */
+void os_geojson_reprojector_init( os_geojson_reprojector_t *reprojector
+                                , os_ellipsoid_t            ellipsoid
+                                , os_helmert_t              helmert
+                                , os_tm_projection_t        projection
+                                , os_geojson_write_t        write
+                                , void                     *context
+                                );
+
+/**
+ * Feed a chunk of the input into the reprojector. The document may be split
+ * arbitrarily between chunks. Returns 1 on success or 0 if the output could
+ * not be written or a position was too large to buffer.
+ */
+int os_geojson_reproject( os_geojson_reprojector_t *reprojector
+                        , const char               *data
+                        , size_t                    length
+                        );
+
+/**
+ * Convert and write any remaining buffered input. Must be called after the
+ * last chunk of input. Returns 1 on success or 0 on failure, including when
+ * the document was truncated (i.e. ends within a string or with unclosed
+ * arrays or objects).
+ */
+int os_geojson_reproject_finish(os_geojson_reprojector_t *reprojector);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
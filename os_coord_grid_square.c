@@ -0,0 +1,162 @@
+/**
+ * OS Coord: A Simple OS Coordinate Transformation Library for C
+ *
+ * This is a port of a the Javascript library produced by Chris Veness available
+ * from http://www.movable-type.co.uk/scripts/latlong-gridref.html.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "os_coord.h"
+#include "os_coord_grid_square.h"
+
+/**
+ * Number of bits of the key sorted by each pass of the radix sort.
+ */
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_MASK (RADIX_SIZE - 1)
+
+/**
+ * Maximum number of radix sort passes required for a 64-bit key.
+ */
+#define RADIX_MAX_PASSES ((64 + RADIX_BITS - 1) / RADIX_BITS)
+
+/**
+ * Extract the given radix digit from a key.
+ */
+#define DIGIT(key, pass) (((key) >> ((pass) * RADIX_BITS)) & RADIX_MASK)
+
+
+uint64_t
+os_grid_square_count( os_grid_t grid
+                    , int       square_size)
+{
+	uint64_t per_100km = 100000 / square_size;
+	return (uint64_t)grid.width * per_100km * (uint64_t)grid.height * per_100km;
+}
+
+
+uint64_t
+os_eas_nor_to_grid_square( os_eas_nor_t point
+                         , os_grid_t    grid
+                         , int          square_size)
+{
+	uint64_t per_100km = 100000 / square_size;
+	uint64_t cols = (uint64_t)grid.width * per_100km;
+	uint64_t rows = (uint64_t)grid.height * per_100km;
+	
+	// Points outside the grid (including NaNs) get the "invalid" key
+	if (!(point.e >= 0.0 && point.n >= 0.0)) {
+		return cols * rows;
+	}
+	
+	double sq_x = point.e / (double)square_size;
+	double sq_y = point.n / (double)square_size;
+	if (sq_x >= (double)cols || sq_y >= (double)rows) {
+		return cols * rows;
+	}
+	
+	return ((uint64_t)sq_y * cols) + (uint64_t)sq_x;
+}
+
+
+os_eas_nor_t
+os_grid_square_to_eas_nor( uint64_t  square
+                         , os_grid_t grid
+                         , int       square_size)
+{
+	uint64_t cols = (uint64_t)grid.width * (100000 / square_size);
+	
+	os_eas_nor_t point;
+	point.e = (double)(square % cols) * (double)square_size;
+	point.n = (double)(square / cols) * (double)square_size;
+	point.h = 0.0;
+	
+	return point;
+}
+
+
+void
+os_grid_square_sort( const os_eas_nor_t *points
+                   , size_t              num_points
+                   , os_grid_t           grid
+                   , int                 square_size
+                   , uint64_t           *squares
+                   , size_t             *permutation
+                   , uint64_t           *scratch_squares
+                   , size_t             *scratch_permutation
+                   )
+{
+	// Only enough passes to cover the largest key (the "invalid" key) are needed
+	uint64_t max_key = os_grid_square_count(grid, square_size);
+	int num_passes = 1;
+	while (num_passes < RADIX_MAX_PASSES
+	       && (max_key >> (num_passes * RADIX_BITS)) != 0) {
+		num_passes++;
+	}
+	
+	// Compute the keys while building the histograms for every pass at once so
+	// that the points are only read once.
+	size_t counts[RADIX_MAX_PASSES][RADIX_SIZE] = {{0}};
+	for (size_t i = 0; i < num_points; i++) {
+		uint64_t key = os_eas_nor_to_grid_square(points[i], grid, square_size);
+		squares[i] = key;
+		permutation[i] = i;
+		for (int pass = 0; pass < num_passes; pass++) {
+			counts[pass][DIGIT(key, pass)]++;
+		}
+	}
+	
+	uint64_t *src_squares = squares;
+	size_t   *src_permutation = permutation;
+	uint64_t *dst_squares = scratch_squares;
+	size_t   *dst_permutation = scratch_permutation;
+	
+	for (int pass = 0; pass < num_passes; pass++) {
+		// Skip passes where every key has the same digit: the order is unchanged.
+		int trivial = 0;
+		for (int d = 0; d < RADIX_SIZE; d++) {
+			if (counts[pass][d] == num_points) {
+				trivial = 1;
+				break;
+			}
+		}
+		if (trivial) {
+			continue;
+		}
+	
+		// Turn the histogram into the starting offset of each digit's bucket
+		size_t offset = 0;
+		for (int d = 0; d < RADIX_SIZE; d++) {
+			size_t count = counts[pass][d];
+			counts[pass][d] = offset;
+			offset += count;
+		}
+	
+		// Scatter (stably) into the buckets
+		for (size_t i = 0; i < num_points; i++) {
+			uint64_t key = src_squares[i];
+			size_t dst = counts[pass][DIGIT(key, pass)]++;
+			dst_squares[dst] = key;
+			dst_permutation[dst] = src_permutation[i];
+		}
+	
+		// Swap buffers
+		uint64_t *tmp_squares = src_squares;
+		size_t   *tmp_permutation = src_permutation;
+		src_squares = dst_squares;
+		src_permutation = dst_permutation;
+		dst_squares = tmp_squares;
+		dst_permutation = tmp_permutation;
+	}
+	
+	// Make sure the result ends up in the output arrays
+	if (src_squares != squares) {
+		for (size_t i = 0; i < num_points; i++) {
+			squares[i] = src_squares[i];
+			permutation[i] = src_permutation[i];
+		}
+	}
+}
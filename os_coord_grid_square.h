@@ -0,0 +1,87 @@
+/**
+ * OS Coord: A Simple OS Coordinate Transformation Library for C
+ *
+ * This is a port of a the Javascript library produced by Chris Veness available
+ * from http://www.movable-type.co.uk/scripts/latlong-gridref.html.
+ *
+ * Grouping of eastings and northings by the grid square (e.g. 100km, 10km or
+ * 1km) they fall within.
+ */
+
+#ifndef OS_COORD_GRID_SQUARE_H
+#define OS_COORD_GRID_SQUARE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "os_coord.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Grid squares are identified by an integer key which numbers the squares of a
+ * given size in the grid row-by-row starting from the bottom-left square. Keys
+ * therefore sort in order of increasing northings and then eastings.
+ *
+ * The square size (m) must exactly divide 100km (e.g. 100000, 10000, 1000, 100,
+ * 10 or 1). Behaviour is undefined otherwise. Keys are 64-bit since the number
+ * of small squares in a grid does not fit in 32 bits (e.g. 9.1e9 10m squares
+ * in the National Grid).
+ */
+
+/**
+ * The number of grid squares of the given size in the grid. This value is also
+ * used as the key of points which do not lie within the grid and so such
+ * points sort after all others.
+ */
+uint64_t os_grid_square_count(os_grid_t grid, int square_size);
+
+/**
+ * Get the key of the grid square of the given size which contains the
+ * specified point. If the point does not lie within the grid,
+ * os_grid_square_count(grid, square_size) is returned.
+ */
+uint64_t os_eas_nor_to_grid_square(os_eas_nor_t point, os_grid_t grid, int square_size);
+
+/**
+ * Get the eastings and northings of the bottom-left corner of the grid square
+ * with the given key (height is zero). This can be passed to
+ * os_eas_nor_to_grid_ref to get the square's grid reference. The key must be a
+ * valid square in the grid.
+ */
+os_eas_nor_t os_grid_square_to_eas_nor(uint64_t square, os_grid_t grid, int square_size);
+
+/**
+ * Group a batch of points by the grid square they lie in using a stable LSD
+ * radix sort of their grid square keys.
+ *
+ * On return, permutation[i] gives the index into points of the i-th point in
+ * sorted order and squares[i] gives the grid square key of that point. Points
+ * in the same grid square are thus contiguous in the output and keep their
+ * original relative order. Points outside the grid are placed at the end.
+ *
+ * squares, permutation, scratch_squares and scratch_permutation must each have
+ * space for num_points entries. No memory is allocated.
+ *
+ * The sort is single-threaded (the library creates no threads). The histograms
+ * of every radix pass are built together while the keys are computed so the
+ * points are only read once, and passes in which all keys share a digit are
+ * skipped.
+ */
+void os_grid_square_sort( const os_eas_nor_t *points
+                        , size_t              num_points
+                        , os_grid_t           grid
+                        , int                 square_size
+                        , uint64_t           *squares
+                        , size_t             *permutation
+                        , uint64_t           *scratch_squares
+                        , size_t             *scratch_permutation
+                        );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,456 @@
+/**
+ * OS Coord: A Simple OS Coordinate Transformation Library for C
+ *
+ * This is a port of a the Javascript library produced by Chris Veness available
+ * from http://www.movable-type.co.uk/scripts/latlong-gridref.html.
+ */
+
+#include <stddef.h>
+
+#include "os_coord.h"
+#include "os_coord_math.h"
+#include "os_coord_transform.h"
+#include "os_coord_ordinance_survey.h"
+#include "os_coord_nmea.h"
+
+/**
+ * Maximum number of comma-separated fields in a sentence which are examined.
+ */
+#define MAX_FIELDS 16
+
+/**
+ * Is the character a decimal digit.
+ */
+#define IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+
+/**
+ * Powers of ten used to scale the fractional part of numbers. Fractional digits
+ * beyond the end of this table are ignored.
+ */
+static const double POW10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12
+};
+#define MAX_FRAC_DIGITS ((int)(sizeof(POW10)/sizeof(POW10[0])) - 1)
+
+/**
+ * Maximum number of integer digits accepted in numeric fields other than times
+ * and angles (which have their own fixed widths). Longer fields are rejected
+ * rather than risking overflow.
+ */
+#define MAX_INT_DIGITS 6
+
+
+/**
+ * Get the value of a (upper or lower case) hex digit, or -1 if not a hex digit.
+ */
+static int
+hex_value(char c)
+{
+	if (IS_DIGIT(c)) {
+		return c - '0';
+	} else if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	} else if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	} else {
+		return -1;
+	}
+}
+
+
+/**
+ * Parse the unsigned integer and fractional parts of a decimal number (without
+ * a sign or exponent) with at most max_int_digits integer digits. Returns 1 on
+ * success or 0 if the field is empty, malformed or too long.
+ */
+static int
+parse_unsigned( const char *field
+              , size_t      length
+              , int         max_int_digits
+              , long       *int_part
+              , double     *frac_part
+              )
+{
+	size_t i = 0;
+	
+	long whole = 0;
+	int num_int_digits = 0;
+	while (i < length && IS_DIGIT(field[i])) {
+		if (num_int_digits == max_int_digits) {
+			return 0;
+		}
+		whole = (whole * 10) + (field[i] - '0');
+		num_int_digits++;
+		i++;
+	}
+	
+	double frac = 0.0;
+	int num_frac_digits = 0;
+	if (i < length && field[i] == '.') {
+		i++;
+		while (i < length && IS_DIGIT(field[i])) {
+			if (num_frac_digits < MAX_FRAC_DIGITS) {
+				frac = (frac * 10.0) + (field[i] - '0');
+				num_frac_digits++;
+			}
+			i++;
+		}
+	}
+	
+	if (i != length || (num_int_digits + num_frac_digits) == 0) {
+		return 0;
+	}
+	
+	*int_part = whole;
+	*frac_part = frac / POW10[num_frac_digits];
+	return 1;
+}
+
+
+/**
+ * Parse a (possibly negative) decimal number.
+ */
+static int
+parse_decimal(const char *field, size_t length, double *value)
+{
+	int negative = (length > 0 && field[0] == '-');
+	long int_part;
+	double frac_part;
+	if (!parse_unsigned(field + negative, length - negative, MAX_INT_DIGITS,
+	                    &int_part, &frac_part)) {
+		return 0;
+	}
+	
+	double magnitude = (double)int_part + frac_part;
+	*value = negative ? -magnitude : magnitude;
+	return 1;
+}
+
+
+/**
+ * Parse a non-negative integer.
+ */
+static int
+parse_int(const char *field, size_t length, int *value)
+{
+	if (length == 0 || length > MAX_INT_DIGITS) {
+		return 0;
+	}
+	
+	int v = 0;
+	for (size_t i = 0; i < length; i++) {
+		if (!IS_DIGIT(field[i])) {
+			return 0;
+		}
+		v = (v * 10) + (field[i] - '0');
+	}
+	
+	*value = v;
+	return 1;
+}
+
+
+/**
+ * Parse a "hhmmss.ss" UTC time into seconds since midnight. Times which are not
+ * valid times of day are rejected (a leap second, ss = 60, is allowed).
+ */
+static int
+parse_time(const char *field, size_t length, double *seconds)
+{
+	long hhmmss;
+	double frac_part;
+	if (!parse_unsigned(field, length, 6, &hhmmss, &frac_part)) {
+		return 0;
+	}
+	
+	long hh = hhmmss / 10000;
+	long mm = (hhmmss / 100) % 100;
+	long ss = hhmmss % 100;
+	if (hh > 23 || mm > 59 || ss > 60) {
+		return 0;
+	}
+	
+	*seconds = (double)((hh * 3600) + (mm * 60) + ss) + frac_part;
+	return 1;
+}
+
+
+/**
+ * Parse a "ddmm.mmmm" latitude (is_latitude non-zero, "N" or "S" hemisphere)
+ * or "dddmm.mmmm" longitude (is_latitude zero, "E" or "W" hemisphere) into
+ * radians. Whether the field is a latitude or longitude is given by its
+ * position in the sentence; a hemisphere of the other kind is rejected, as are
+ * angles with whole minutes of 60 or more or which are out of range (more than
+ * 90 degrees of latitude or 180 degrees of longitude).
+ */
+static int
+parse_angle( const char *field
+           , size_t      length
+           , const char *hemisphere
+           , size_t      hemisphere_length
+           , int         is_latitude
+           , double     *radians
+           )
+{
+	if (hemisphere_length != 1) {
+		return 0;
+	}
+	
+	double sign;
+	if (hemisphere[0] == (is_latitude ? 'N' : 'E')) {
+		sign = 1.0;
+	} else if (hemisphere[0] == (is_latitude ? 'S' : 'W')) {
+		sign = -1.0;
+	} else {
+		return 0;
+	}
+	
+	long dddmm;
+	double frac_part;
+	if (!parse_unsigned(field, length, is_latitude ? 4 : 5, &dddmm, &frac_part)) {
+		return 0;
+	}
+	
+	// The last two integer digits are whole minutes, the rest are degrees
+	if (dddmm % 100 >= 60) {
+		return 0;
+	}
+	double minutes = (double)(dddmm % 100) + frac_part;
+	double degrees = (double)(dddmm / 100) + (minutes / 60.0);
+	if (degrees > (is_latitude ? 90.0 : 180.0)) {
+		return 0;
+	}
+	
+	*radians = sign * DEG_2_RAD(degrees);
+	return 1;
+}
+
+
+void
+os_nmea_parser_init(os_nmea_parser_t *parser)
+{
+	parser->length = 0;
+	parser->in_sentence = 0;
+	parser->num_errors = 0;
+}
+
+
+/**
+ * Parse a single sentence. Returns 1 if a fix was extracted, 0 if the sentence
+ * was valid but did not contain a fix and -1 if the sentence had a missing or
+ * bad checksum.
+ */
+static int
+parse_sentence( const char    *sentence
+              , size_t         length
+              , os_nmea_fix_t *fix
+              )
+{
+	// Must have at least "$*XX"
+	if (length < 4 || sentence[0] != '$' || sentence[length - 3] != '*') {
+		return -1;
+	}
+	
+	// Check the checksum (the XOR of all characters between the '$' and '*')
+	int hi = hex_value(sentence[length - 2]);
+	int lo = hex_value(sentence[length - 1]);
+	if (hi < 0 || lo < 0) {
+		return -1;
+	}
+	unsigned char checksum = 0;
+	for (size_t i = 1; i < length - 3; i++) {
+		checksum ^= (unsigned char)sentence[i];
+	}
+	if (checksum != (unsigned char)((hi << 4) | lo)) {
+		return -1;
+	}
+	
+	// Split into fields
+	const char *fields[MAX_FIELDS];
+	size_t field_lengths[MAX_FIELDS];
+	int num_fields = 0;
+	const char *start = sentence + 1;
+	const char *end = sentence + length - 3;
+	for (const char *c = start; num_fields < MAX_FIELDS; c++) {
+		if (c == end || *c == ',') {
+			fields[num_fields] = start;
+			field_lengths[num_fields] = (size_t)(c - start);
+			num_fields++;
+			start = c + 1;
+		}
+		if (c == end) {
+			break;
+		}
+	}
+	
+	// The address field is a two-character talker ID followed by the sentence
+	// type. Any talker is accepted.
+	if (field_lengths[0] != 5) {
+		return 0;
+	}
+	const char *type = fields[0] + 2;
+	
+	os_nmea_fix_t new_fix = {.lat_lon={.eh=0.0}};
+	
+	if (type[0] == 'G' && type[1] == 'G' && type[2] == 'A') {
+		// $--GGA,hhmmss.ss,llll.ll,a,yyyyy.yy,a,q,nn,h.h,a.a,M,g.g,M,...
+		if (num_fields < 12) {
+			return 0;
+		}
+	
+		new_fix.sentence = OS_NMEA_GGA;
+	
+		// A quality of zero means there is no fix
+		if (!parse_int(fields[6], field_lengths[6], &new_fix.quality)
+		    || new_fix.quality == 0) {
+			return 0;
+		}
+	
+		if (!parse_time(fields[1], field_lengths[1], &new_fix.time)
+		    || !parse_angle(fields[2], field_lengths[2],
+		                    fields[3], field_lengths[3],
+		                    1, &new_fix.lat_lon.lat)
+		    || !parse_angle(fields[4], field_lengths[4],
+		                    fields[5], field_lengths[5],
+		                    0, &new_fix.lat_lon.lon)
+		    || !parse_decimal(fields[9], field_lengths[9], &new_fix.altitude)) {
+			return 0;
+		}
+	
+		// Some receivers leave the geoid separation empty, in which case it is
+		// taken as zero (see os_nmea_fix_t).
+		if (field_lengths[11] != 0
+		    && !parse_decimal(fields[11], field_lengths[11], &new_fix.geoid_separation)) {
+			return 0;
+		}
+	
+		// The satellite count and HDOP are informative only and so may be absent
+		parse_int(fields[7], field_lengths[7], &new_fix.num_satellites);
+		parse_decimal(fields[8], field_lengths[8], &new_fix.hdop);
+	
+		new_fix.lat_lon.eh = new_fix.altitude + new_fix.geoid_separation;
+	} else if (type[0] == 'R' && type[1] == 'M' && type[2] == 'C') {
+		// $--RMC,hhmmss.ss,A,llll.ll,a,yyyyy.yy,a,x.x,x.x,xxxxxx,x.x,a,...
+		if (num_fields < 7) {
+			return 0;
+		}
+	
+		new_fix.sentence = OS_NMEA_RMC;
+	
+		// A status other than 'A' (active) means there is no fix
+		if (field_lengths[2] != 1 || fields[2][0] != 'A') {
+			return 0;
+		}
+		new_fix.quality = 1;
+	
+		if (!parse_time(fields[1], field_lengths[1], &new_fix.time)
+		    || !parse_angle(fields[3], field_lengths[3],
+		                    fields[4], field_lengths[4],
+		                    1, &new_fix.lat_lon.lat)
+		    || !parse_angle(fields[5], field_lengths[5],
+		                    fields[6], field_lengths[6],
+		                    0, &new_fix.lat_lon.lon)) {
+			return 0;
+		}
+	} else {
+		return 0;
+	}
+	
+	*fix = new_fix;
+	return 1;
+}
+
+
+int
+os_nmea_parse_sentence( const char    *sentence
+                      , size_t         length
+                      , os_nmea_fix_t *fix
+                      )
+{
+	return parse_sentence(sentence, length, fix) > 0;
+}
+
+
+size_t
+os_nmea_parse( os_nmea_parser_t *parser
+             , const char       *data
+             , size_t            length
+             , os_nmea_fix_t    *fixes
+             , size_t            max_fixes
+             , size_t           *num_fixes
+             )
+{
+	*num_fixes = 0;
+	
+	size_t i;
+	for (i = 0; i < length && *num_fixes < max_fixes; i++) {
+		char c = data[i];
+	
+		if (c == '$') {
+			// Start of a new sentence (abandoning any incomplete one)
+			if (parser->in_sentence) {
+				parser->num_errors++;
+			}
+			parser->sentence[0] = c;
+			parser->length = 1;
+			parser->in_sentence = 1;
+		} else if (!parser->in_sentence) {
+			// Skip anything between sentences
+			continue;
+		} else if (c == '\r' || c == '\n') {
+			// End of sentence
+			parser->in_sentence = 0;
+			int result = parse_sentence(parser->sentence, parser->length,
+			                            &fixes[*num_fixes]);
+			if (result > 0) {
+				(*num_fixes)++;
+			} else if (result < 0) {
+				parser->num_errors++;
+			}
+		} else if (parser->length == OS_NMEA_MAX_SENTENCE_LENGTH) {
+			// Too long
+			parser->in_sentence = 0;
+			parser->num_errors++;
+		} else {
+			parser->sentence[parser->length++] = c;
+		}
+	}
+	
+	return i;
+}
+
+
+void
+os_nmea_fixes_to_grid_ref( const os_nmea_fix_t *fixes
+                         , size_t               num_fixes
+                         , os_grid_ref_t       *grid_refs
+                         , os_ellipsoid_t       ellipsoid
+                         , os_helmert_t         helmert
+                         , os_tm_projection_t   projection
+                         , os_grid_t            grid
+                         )
+{
+	os_lat_lon_t   lat_lons[OS_NMEA_BATCH_SIZE];
+	os_cartesian_t carts[OS_NMEA_BATCH_SIZE];
+	os_eas_nor_t   eas_nors[OS_NMEA_BATCH_SIZE];
+	
+	for (size_t first = 0; first < num_fixes; first += OS_NMEA_BATCH_SIZE) {
+		size_t n = num_fixes - first;
+		if (n > OS_NMEA_BATCH_SIZE) {
+			n = OS_NMEA_BATCH_SIZE;
+		}
+	
+		for (size_t i = 0; i < n; i++) {
+			lat_lons[i] = fixes[first + i].lat_lon;
+		}
+	
+		os_lat_lon_to_cartesian_batch(lat_lons, carts, n, ellipsoid);
+		os_helmert_transform_batch(carts, carts, n, helmert);
+		os_cartesian_to_lat_lon_batch(carts, lat_lons, n, projection.ellipsoid);
+		os_lat_lon_to_tm_eas_nor_batch(lat_lons, eas_nors, n, projection);
+	
+		for (size_t i = 0; i < n; i++) {
+			grid_refs[first + i] = os_eas_nor_to_grid_ref(eas_nors[i], grid);
+		}
+	}
+}
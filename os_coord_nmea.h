@@ -0,0 +1,155 @@
+/**
+ * OS Coord: A Simple OS Coordinate Transformation Library for C
+ *
+ * This is a port of a the Javascript library produced by Chris Veness available
+ * from http://www.movable-type.co.uk/scripts/latlong-gridref.html.
+ *
+ * A streaming parser for the position fixes in NMEA 0183 GGA and RMC sentences
+ * as produced by GPS receivers. The parser never allocates memory or uses
+ * stdio and so many streams may be parsed side-by-side cheaply.
+ */
+
+#ifndef OS_COORD_NMEA_H
+#define OS_COORD_NMEA_H
+
+#include <stddef.h>
+
+#include "os_coord.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Maximum length of an NMEA sentence (from the '$' up to and including the
+ * checksum but not the line ending). Longer sentences are discarded.
+ */
+#define OS_NMEA_MAX_SENTENCE_LENGTH 82
+
+/**
+ * Number of fixes converted at once by os_nmea_fixes_to_grid_ref. This many
+ * intermediate points of each type are kept on the stack.
+ */
+#define OS_NMEA_BATCH_SIZE 64
+
+/**
+ * The type of sentence a fix was extracted from.
+ */
+typedef enum os_nmea_sentence {
+	OS_NMEA_GGA,
+	OS_NMEA_RMC,
+} os_nmea_sentence_t;
+
+/**
+ * A position fix extracted from an NMEA sentence.
+ */
+typedef struct os_nmea_fix {
+	// The sentence the fix came from.
+	os_nmea_sentence_t sentence;
+	
+	// UTC time of day of the fix (seconds since midnight)
+	double time;
+	
+	// WGS84 position. For GGA sentences the ellipsoidal height is the altitude
+	// plus the geoid separation. RMC sentences do not give a height and so the
+	// ellipsoidal height is zero.
+	os_lat_lon_t lat_lon;
+	
+	// Altitude above mean sea level (m) (GGA only, otherwise zero)
+	double altitude;
+	
+	// Height of the geoid above the WGS84 ellipsoid (m) (GGA only, otherwise
+	// zero). Some receivers leave this field empty in which case it is zero and
+	// so the ellipsoidal height above is just the altitude.
+	double geoid_separation;
+	
+	// GGA fix quality indicator (1 = GPS, 2 = DGPS, etc.). Always 1 for RMC.
+	int quality;
+	
+	// Number of satellites in use (GGA only, otherwise zero)
+	int num_satellites;
+	
+	// Horizontal dilution of precision (GGA only, otherwise zero)
+	double hdop;
+} os_nmea_fix_t;
+
+/**
+ * State of a streaming NMEA parser. Initialise with os_nmea_parser_init.
+ */
+typedef struct os_nmea_parser {
+	// The sentence received so far
+	char sentence[OS_NMEA_MAX_SENTENCE_LENGTH];
+	size_t length;
+	
+	// Non-zero while a sentence is being received
+	int in_sentence;
+	
+	// Number of sentences discarded due to a bad or missing checksum or due to
+	// being too long.
+	unsigned long num_errors;
+} os_nmea_parser_t;
+
+
+/**
+ * Initialise (or reset) a streaming NMEA parser.
+ */
+void os_nmea_parser_init(os_nmea_parser_t *parser);
+
+/**
+ * Feed a chunk of a byte stream into the parser. Sentences may be split
+ * arbitrarily between chunks.
+ *
+ * Fixes are written into fixes (at most max_fixes) and the number written
+ * stored in *num_fixes. Sentences other than GGA and RMC, and sentences which
+ * do not contain a valid fix, are skipped.
+ *
+ * Returns the number of bytes consumed. This is less than length only if
+ * max_fixes fixes were produced in which case the remaining bytes should be
+ * fed in again once the fixes have been processed.
+ */
+size_t os_nmea_parse( os_nmea_parser_t *parser
+                    , const char       *data
+                    , size_t            length
+                    , os_nmea_fix_t    *fixes
+                    , size_t            max_fixes
+                    , size_t           *num_fixes
+                    );
+
+/**
+ * Parse a single complete sentence (starting with '$' and ending with the
+ * checksum, without the line ending). Returns 1 and fills in *fix if the
+ * sentence is a GGA or RMC sentence with a valid checksum and fix. Returns 0
+ * otherwise, including when any field used is malformed, longer than its
+ * format allows or out of range (e.g. minutes of 60 or more, a latitude beyond
+ * 90 degrees or an invalid time of day).
+ */
+int os_nmea_parse_sentence(const char *sentence, size_t length, os_nmea_fix_t *fix);
+
+/**
+ * Convert a batch of fixes into grid references. The WGS84 positions are
+ * converted to cartesian coordinates, transformed using the supplied Helmert
+ * transform onto the projection's ellipsoid, projected and finally turned
+ * into grid references. This is equivalent to converting each point with
+ * os_lat_lon_to_cartesian, os_helmert_transform, os_cartesian_to_lat_lon,
+ * os_lat_lon_to_tm_eas_nor and os_eas_nor_to_grid_ref.
+ *
+ * For example, to produce OS National Grid references use:
+ *
+ *   os_nmea_fixes_to_grid_ref(fixes, num_fixes, grid_refs,
+ *                             OS_EL_WGS84, OS_HE_WGS84_TO_OSGB36,
+ *                             OS_TM_NATIONAL_GRID, OS_GR_NATIONAL_GRID);
+ */
+void os_nmea_fixes_to_grid_ref( const os_nmea_fix_t *fixes
+                              , size_t               num_fixes
+                              , os_grid_ref_t       *grid_refs
+                              , os_ellipsoid_t       ellipsoid
+                              , os_helmert_t         helmert
+                              , os_tm_projection_t   projection
+                              , os_grid_t            grid
+                              );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -10,6 +10,9 @@
 
 #include "os_coord.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 /**
  * Transform a set of eastings and northings into a Ordinance Survey style grid
@@ -27,4 +30,8 @@ os_grid_ref_t os_eas_nor_to_grid_ref(os_eas_nor_t point, os_grid_t grid);
  */
 os_eas_nor_t os_grid_ref_to_eas_nor(os_grid_ref_t point, os_grid_t grid);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,236 @@
+/**
+ * OS Coord: A Simple OS Coordinate Transformation Library for C
+ *
+ * This is a port of a the Javascript library produced by Chris Veness available
+ * from http://www.movable-type.co.uk/scripts/latlong-gridref.html.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "os_coord.h"
+#include "os_coord_grid_square.h"
+#include "os_coord_ordinance_survey.h"
+#include "os_coord_point_file.h"
+
+/**
+ * Round a size up to a multiple of 8 bytes.
+ */
+#define ALIGN8(n) (((n) + 7) & ~((size_t)7))
+
+/**
+ * Size of 100km squares in m.
+ */
+#define SQUARE_SIZE 100000
+
+
+/**
+ * Compute the offsets of each section of a file.
+ */
+static void
+layout( size_t                  num_points
+      , os_grid_t               grid
+      , int                     flags
+      , os_point_file_header_t *header
+      , size_t                 *size
+      )
+{
+	size_t num_squares = os_grid_square_count(grid, SQUARE_SIZE);
+	
+	size_t offset = ALIGN8(sizeof(os_point_file_header_t));
+	header->index_offset = offset;
+	offset += (num_squares + 2) * sizeof(uint64_t);
+	header->e_offset = offset;
+	offset += num_points * sizeof(double);
+	header->n_offset = offset;
+	offset += num_points * sizeof(double);
+	header->h_offset = offset;
+	offset += num_points * sizeof(double);
+	if (flags & OS_POINT_FILE_GRID_REFS) {
+		header->grid_ref_offset = offset;
+		offset += ALIGN8(num_points * 4);
+	} else {
+		header->grid_ref_offset = 0;
+	}
+	
+	header->num_squares = num_squares;
+	*size = offset;
+}
+
+
+size_t
+os_point_file_size( size_t    num_points
+                  , os_grid_t grid
+                  , int       flags
+                  )
+{
+	os_point_file_header_t header;
+	size_t size;
+	layout(num_points, grid, flags, &header, &size);
+	return size;
+}
+
+
+void
+os_point_file_write( void               *buffer
+                   , const os_eas_nor_t *points
+                   , size_t              num_points
+                   , const uint64_t     *squares
+                   , const size_t       *permutation
+                   , os_tm_projection_t  projection
+                   , os_grid_t           grid
+                   , int                 flags
+                   )
+{
+	os_point_file_header_t *header = buffer;
+	size_t size;
+	memset(header, 0, sizeof(os_point_file_header_t));
+	layout(num_points, grid, flags, header, &size);
+	
+	memcpy(header->magic, OS_POINT_FILE_MAGIC, sizeof(header->magic));
+	header->version = OS_POINT_FILE_VERSION;
+	header->flags = flags;
+	header->num_points = num_points;
+	
+	header->e0 = projection.e0;
+	header->n0 = projection.n0;
+	header->f0 = projection.f0;
+	header->lat0 = projection.lat0;
+	header->lon0 = projection.lon0;
+	header->a = projection.ellipsoid.a;
+	header->b = projection.ellipsoid.b;
+	
+	header->num_digits = grid.num_digits;
+	header->bottom_left_first_char = grid.bottom_left_first_char;
+	header->width = grid.width;
+	header->height = grid.height;
+	
+	char *base = buffer;
+	uint64_t *index = (uint64_t *)(base + header->index_offset);
+	double *e = (double *)(base + header->e_offset);
+	double *n = (double *)(base + header->n_offset);
+	double *h = (double *)(base + header->h_offset);
+	char (*grid_refs)[4] = (flags & OS_POINT_FILE_GRID_REFS)
+	                       ? (char (*)[4])(base + header->grid_ref_offset)
+	                       : NULL;
+	
+	// Write the columns in sorted order, recording where each square starts.
+	// Squares containing no points start where the next non-empty square does.
+	size_t square = 0;
+	for (size_t i = 0; i < num_points; i++) {
+		while (square <= squares[i]) {
+			index[square++] = i;
+		}
+	
+		os_eas_nor_t point = points[permutation[i]];
+		e[i] = point.e;
+		n[i] = point.n;
+		h[i] = point.h;
+	
+		if (grid_refs) {
+			os_grid_ref_t grid_ref = os_eas_nor_to_grid_ref(point, grid);
+			memcpy(grid_refs[i], grid_ref.code, sizeof(grid_ref.code));
+			grid_refs[i][3] = '\0';
+		}
+	}
+	while (square < header->num_squares + 2) {
+		index[square++] = num_points;
+	}
+	
+	// Zero any padding after the grid reference column
+	if (grid_refs) {
+		memset(grid_refs + num_points, 0,
+		       size - (header->grid_ref_offset + (num_points * 4)));
+	}
+}
+
+
+int
+os_point_file_read( const void      *buffer
+                  , size_t           size
+                  , os_point_file_t *file
+                  )
+{
+	const os_point_file_header_t *header = buffer;
+	
+	if (((uintptr_t)buffer % 8) != 0
+	    || size < sizeof(os_point_file_header_t)
+	    || memcmp(header->magic, OS_POINT_FILE_MAGIC, sizeof(header->magic)) != 0
+	    || header->version != OS_POINT_FILE_VERSION
+	    || (header->flags & ~OS_POINT_FILE_GRID_REFS) != 0
+	    || header->num_points > size / sizeof(double)) {
+		return 0;
+	}
+	
+	os_grid_t grid;
+	grid.num_digits = header->num_digits;
+	grid.bottom_left_first_char = (char)header->bottom_left_first_char;
+	grid.width = header->width;
+	grid.height = header->height;
+	if (grid.num_digits < 1 || grid.num_digits > 2
+	    || grid.width < 1 || grid.width > 25
+	    || grid.height < 1 || grid.height > 25) {
+		return 0;
+	}
+	
+	// The layout must be exactly that produced by the writer
+	os_point_file_header_t expected;
+	size_t expected_size;
+	layout(header->num_points, grid, header->flags, &expected, &expected_size);
+	if (expected_size > size
+	    || expected.num_squares != header->num_squares
+	    || expected.index_offset != header->index_offset
+	    || expected.e_offset != header->e_offset
+	    || expected.n_offset != header->n_offset
+	    || expected.h_offset != header->h_offset
+	    || expected.grid_ref_offset != header->grid_ref_offset) {
+		return 0;
+	}
+	
+	// The index must be non-decreasing and cover every point
+	const char *base = buffer;
+	const uint64_t *index = (const uint64_t *)(base + header->index_offset);
+	if (index[0] != 0 || index[header->num_squares + 1] != header->num_points) {
+		return 0;
+	}
+	for (size_t s = 0; s < header->num_squares + 1; s++) {
+		if (index[s] > index[s + 1]) {
+			return 0;
+		}
+	}
+	
+	file->projection.e0 = header->e0;
+	file->projection.n0 = header->n0;
+	file->projection.f0 = header->f0;
+	file->projection.lat0 = header->lat0;
+	file->projection.lon0 = header->lon0;
+	file->projection.ellipsoid.a = header->a;
+	file->projection.ellipsoid.b = header->b;
+	file->grid = grid;
+	
+	file->num_points = header->num_points;
+	file->num_squares = header->num_squares;
+	
+	file->index = index;
+	file->e = (const double *)(base + header->e_offset);
+	file->n = (const double *)(base + header->n_offset);
+	file->h = (const double *)(base + header->h_offset);
+	file->grid_refs = header->grid_ref_offset
+	                  ? (const char (*)[4])(base + header->grid_ref_offset)
+	                  : NULL;
+	
+	return 1;
+}
+
+
+void
+os_point_file_square( const os_point_file_t *file
+                    , uint64_t               square
+                    , size_t                *first
+                    , size_t                *num_points
+                    )
+{
+	*first = file->index[square];
+	*num_points = file->index[square + 1] - file->index[square];
+}
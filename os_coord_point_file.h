@@ -0,0 +1,164 @@
+/**
+ * OS Coord: A Simple OS Coordinate Transformation Library for C
+ *
+ * This is a port of a the Javascript library produced by Chris Veness available
+ * from http://www.movable-type.co.uk/scripts/latlong-gridref.html.
+ *
+ * A binary columnar file format for storing large numbers of projected points
+ * such that they can be memory-mapped and read without any parsing.
+ *
+ * A file consists of (with every section starting on an 8-byte boundary):
+ *
+ *   - A header (os_point_file_header_t) giving the projection and grid the
+ *     points are stored in and the offsets of the other sections.
+ *   - An index of (num_squares + 2) uint64_t values. Points are stored sorted by
+ *     the 100km grid square they lie in (see os_coord_grid_square.h) and
+ *     index[s] gives the first point in square s. index[num_squares] is the
+ *     first point lying outside the grid and index[num_squares + 1] is the
+ *     number of points.
+ *   - Columns of eastings, northings and heights (doubles).
+ *   - Optionally, a column of grid reference codes (char[4], NULL terminated
+ *     and empty for points outside the grid).
+ *
+ * All values are stored in the byte order of the machine which wrote the file.
+ * Readers on machines with a different byte order will reject the file since
+ * the version number will not match.
+ */
+
+#ifndef OS_COORD_POINT_FILE_H
+#define OS_COORD_POINT_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "os_coord.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Magic number at the start of every file (not NULL terminated).
+ */
+#define OS_POINT_FILE_MAGIC "OSPOINTS"
+
+/**
+ * Version of the file format.
+ */
+#define OS_POINT_FILE_VERSION 1
+
+/**
+ * Flag indicating the file includes a grid reference code column.
+ */
+#define OS_POINT_FILE_GRID_REFS 0x1
+
+/**
+ * The on-disk file header.
+ */
+typedef struct os_point_file_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t flags;
+	
+	uint64_t num_points;
+	
+	// The projection the points are in
+	double e0;
+	double n0;
+	double f0;
+	double lat0;
+	double lon0;
+	double a;
+	double b;
+	
+	// The grid used to group points into squares
+	int32_t num_digits;
+	int32_t bottom_left_first_char;
+	int32_t width;
+	int32_t height;
+	
+	// Number of 100km grid squares in the grid
+	uint64_t num_squares;
+	
+	// Offsets (in bytes from the start of the file) of each section. The grid
+	// reference offset is zero if the column is not present.
+	uint64_t index_offset;
+	uint64_t e_offset;
+	uint64_t n_offset;
+	uint64_t h_offset;
+	uint64_t grid_ref_offset;
+} os_point_file_header_t;
+
+/**
+ * A (read-only) view of a point file in memory.
+ */
+typedef struct os_point_file {
+	os_tm_projection_t projection;
+	os_grid_t grid;
+	
+	size_t num_points;
+	size_t num_squares;
+	
+	// Index of the first point in each grid square (see above).
+	const uint64_t *index;
+	
+	// Columns
+	const double *e;
+	const double *n;
+	const double *h;
+	
+	// Grid reference codes or NULL if not present.
+	const char (*grid_refs)[4];
+} os_point_file_t;
+
+
+/**
+ * Get the size (in bytes) of a file holding the given number of points.
+ */
+size_t os_point_file_size(size_t num_points, os_grid_t grid, int flags);
+
+/**
+ * Write a file into a buffer of (at least) os_point_file_size bytes which must
+ * be 8-byte aligned.
+ *
+ * The points must already have been grouped into 100km squares using
+ * os_grid_square_sort(points, num_points, grid, 100000, squares, permutation,
+ * ...) and the resulting squares and permutation passed in. The flags may
+ * include OS_POINT_FILE_GRID_REFS.
+ */
+void os_point_file_write( void               *buffer
+                        , const os_eas_nor_t *points
+                        , size_t              num_points
+                        , const uint64_t     *squares
+                        , const size_t       *permutation
+                        , os_tm_projection_t  projection
+                        , os_grid_t           grid
+                        , int                 flags
+                        );
+
+/**
+ * Open a file held in memory (e.g. mmapped). The buffer must be 8-byte aligned
+ * and remain valid while the file is in use. Nothing is copied.
+ *
+ * Returns 1 and fills in *file if the file is valid. Returns 0 if the buffer
+ * does not hold a valid file (of this version and byte order).
+ */
+int os_point_file_read(const void *buffer, size_t size, os_point_file_t *file);
+
+/**
+ * Get the range of points in a given 100km grid square (as numbered by
+ * os_eas_nor_to_grid_square(point, grid, 100000)). The points in the square are
+ * those numbered *first to (*first + *num_points - 1). Passing num_squares gives
+ * the points lying outside the grid.
+ */
+void os_point_file_square( const os_point_file_t *file
+                         , uint64_t               square
+                         , size_t                *first
+                         , size_t                *num_points
+                         );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -11,8 +11,14 @@
 #ifndef OS_COORD_TRANSFORM_H
 #define OS_COORD_TRANSFORM_H
 
+#include <stddef.h>
+
 #include "os_coord.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * Conversion from cartesian to lat-lon coordinates is done via an iterative
  * algorithm. This constant defines the number of meters precision to achieve.
@@ -27,37 +33,91 @@
  */
 #define OS_EAS_NOR_TO_LAT_LON_PRECISION 0.00001
 
+/**
+ * Each conversion below also has a "_batch" version which converts num_points
+ * points from one array into another. These produce identical results to
+ * calling the single-point version on each point but only compute values
+ * derived from the ellipsoid/projection/Helmert parameters once per batch.
+ */
+
+/**
+ * The batch conversions are compiled for several instruction sets (when built
+ * with the Makefile on x86: "baseline", "avx2" (with FMA) and "avx512") and the
+ * best one supported by the CPU is chosen when the program starts. Setting the
+ * environment variable OS_COORD_ISA to one of these names forces that variant
+ * (if the CPU supports it). The variants may differ in the last bit or so of
+ * their results since they are free to use fused multiply-adds.
+ *
+ * Returns the name of the variant in use.
+ */
+const char *os_transform_isa(void);
+
 /**
  * Convert a lat/lon/eh point on an ellipsoid to the corresponding point in 3D
  * cartesian space.
  */
 os_cartesian_t os_lat_lon_to_cartesian(os_lat_lon_t point, os_ellipsoid_t ellipsoid);
 
+void os_lat_lon_to_cartesian_batch( const os_lat_lon_t *points
+                                  , os_cartesian_t     *cart_points
+                                  , size_t              num_points
+                                  , os_ellipsoid_t      ellipsoid
+                                  );
+
 /**
  * Convert a 3D cartesian point into a lat/lon/eh point on an ellipsoid.
  */
 os_lat_lon_t os_cartesian_to_lat_lon(os_cartesian_t point, os_ellipsoid_t ellipsoid);
 
+void os_cartesian_to_lat_lon_batch( const os_cartesian_t *points
+                                  , os_lat_lon_t         *lat_lons
+                                  , size_t                num_points
+                                  , os_ellipsoid_t        ellipsoid
+                                  );
+
 /**
  * Transform a set of Helmert parameters to give the inverse transform.
  */
 os_helmert_t os_helmert_invert(os_helmert_t helmert);
 
 /**
- * Perform a Helmert transform on a point in cartesian space.
+ * Perform a Helmert transform on a point in cartesian space. The batch version
+ * may be performed in place (i.e. points == new_points).
  */
 os_cartesian_t os_helmert_transform(os_cartesian_t point, os_helmert_t helmert);
 
+void os_helmert_transform_batch( const os_cartesian_t *points
+                               , os_cartesian_t       *new_points
+                               , size_t                num_points
+                               , os_helmert_t          helmert
+                               );
+
 /**
  * Transform a lat/lon/eh into eastings and northings using a transverse
  * mercator projection. Ellipsoidal height is copied verbatim.
  */
 os_eas_nor_t os_lat_lon_to_tm_eas_nor(os_lat_lon_t point, os_tm_projection_t projection);
 
+void os_lat_lon_to_tm_eas_nor_batch( const os_lat_lon_t *points
+                                   , os_eas_nor_t       *eas_nors
+                                   , size_t              num_points
+                                   , os_tm_projection_t  projection
+                                   );
+
 /**
  * Transform a set of eastings and northings into lat/lon/eh from a transverse
  * mercator projection. Height is copied verbatim.
  */
 os_lat_lon_t os_tm_eas_nor_to_lat_lon(os_eas_nor_t point, os_tm_projection_t projection);
 
+void os_tm_eas_nor_to_lat_lon_batch( const os_eas_nor_t *points
+                                   , os_lat_lon_t       *lat_lons
+                                   , size_t              num_points
+                                   , os_tm_projection_t  projection
+                                   );
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,32 @@
+/**
+ * OS Coord: A Simple OS Coordinate Transformation Library for C
+ *
+ * This is a port of a the Javascript library produced by Chris Veness available
+ * from http://www.movable-type.co.uk/scripts/latlong-gridref.html.
+ *
+ * Batch transform kernels compiled for x86 CPUs with AVX-512 (F, DQ and VL,
+ * e.g. Intel Skylake-SP, AMD Zen 4 and later). See
+ * os_coord_transform_kernels.h.
+ */
+
+#include <stddef.h>
+#include <math.h>
+
+#include "os_coord.h"
+#include "os_coord_transform_kernels.h"
+
+#if OS_TRANSFORM_MULTI_ISA
+
+// Must be compiled with the instruction set enabled (and multiplies and adds
+// allowed to fuse), e.g. "-mavx512f -mavx512dq -mavx512vl -mavx2 -mfma
+// -ffp-contract=fast" (see the Makefile)
+#if !defined(__AVX512F__) || !defined(__AVX512DQ__) || !defined(__AVX512VL__) \
+    || !defined(__FMA__)
+#error "Instruction set not enabled"
+#endif
+
+#define OS_TRANSFORM_KERNELS_NAME os_transform_kernels_avx512
+#define OS_TRANSFORM_KERNELS_ISA  "avx512"
+#include "os_coord_transform_kernels.h"
+
+#endif
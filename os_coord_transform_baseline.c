@@ -0,0 +1,19 @@
+/**
+ * OS Coord: A Simple OS Coordinate Transformation Library for C
+ *
+ * This is a port of a the Javascript library produced by Chris Veness available
+ * from http://www.movable-type.co.uk/scripts/latlong-gridref.html.
+ *
+ * Batch transform kernels compiled for the baseline instruction set of the
+ * target (see os_coord_transform_kernels.h).
+ */
+
+#include <stddef.h>
+#include <math.h>
+
+#include "os_coord.h"
+#include "os_coord_transform_kernels.h"
+
+#define OS_TRANSFORM_KERNELS_NAME os_transform_kernels_baseline
+#define OS_TRANSFORM_KERNELS_ISA  "baseline"
+#include "os_coord_transform_kernels.h"
@@ -0,0 +1,122 @@
+/**
+ * Benchmark comparing the C and header-only C++ (os_coord.hpp) conversions of
+ * WGS84 lat/lon into OS National Grid eastings and northings.
+ *
+ * Compilation (from this directory):
+ *   make -C ..
+ *   g++ -std=c++20 -O2 -I.. os_coord_bench.cpp ../libos_coord.a -ltbb -o os_coord_bench
+ *
+ * Usage:
+ *   ./os_coord_bench [num_points]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <vector>
+
+#include "os_coord.hpp"
+
+using namespace os_coord;
+
+/**
+ * Run a conversion of every point, returning the time taken in seconds.
+ */
+template <class F>
+static double
+time_it(F f)
+{
+	auto start = std::chrono::steady_clock::now();
+	f();
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(end - start).count();
+}
+
+
+/**
+ * Hand-fused C: every stage applied to each point in turn.
+ */
+static void
+c_fused(const std::vector<os_lat_lon_t> &in, std::vector<os_eas_nor_t> &out)
+{
+	for (std::size_t i = 0; i < in.size(); i++) {
+		os_cartesian_t c = os_lat_lon_to_cartesian(in[i], wgs84);
+		c = os_helmert_transform(c, wgs84_to_osgb36);
+		os_lat_lon_t ll = os_cartesian_to_lat_lon(c, airy_1830);
+		out[i] = os_lat_lon_to_tm_eas_nor(ll, national_grid);
+	}
+}
+
+
+/**
+ * C batch functions: each stage applied to every point in turn.
+ */
+static void
+c_batch(const std::vector<os_lat_lon_t> &in, std::vector<os_eas_nor_t> &out)
+{
+	std::vector<os_cartesian_t> c(in.size());
+	std::vector<os_lat_lon_t> ll(in.size());
+	os_lat_lon_to_cartesian_batch(in.data(), c.data(), in.size(), wgs84);
+	os_helmert_transform_batch(c.data(), c.data(), c.size(), wgs84_to_osgb36);
+	os_cartesian_to_lat_lon_batch(c.data(), ll.data(), c.size(), airy_1830);
+	os_lat_lon_to_tm_eas_nor_batch(ll.data(), out.data(), ll.size(), national_grid);
+}
+
+
+/**
+ * Compare results against the reference. The C kernels in use may fuse
+ * multiplies and adds (see os_transform_isa) which changes the last few bits
+ * so only agreement to well under a millimetre is required.
+ */
+static const char *
+check(const std::vector<os_eas_nor_t> &out, const std::vector<os_eas_nor_t> &reference)
+{
+	for (std::size_t i = 0; i < out.size(); i++) {
+		if (std::fabs(out[i].e - reference[i].e) > 1e-6
+		    || std::fabs(out[i].n - reference[i].n) > 1e-6
+		    || std::fabs(out[i].h - reference[i].h) > 1e-6) {
+			return " (MISMATCH)";
+		}
+	}
+	return "";
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	std::size_t num_points = (argc == 2) ? std::strtoul(argv[1], NULL, 10) : 2000000;
+	
+	std::vector<os_lat_lon_t> in(num_points);
+	std::srand(1);
+	for (auto &p : in) {
+		p.lat = detail::deg_2_rad(50.0 + 9.0 * std::rand() / RAND_MAX);
+		p.lon = detail::deg_2_rad(-6.0 + 8.0 * std::rand() / RAND_MAX);
+		p.eh = 100.0 * std::rand() / RAND_MAX;
+	}
+	
+	std::vector<os_eas_nor_t> reference(num_points);
+	std::vector<os_eas_nor_t> out(num_points);
+	
+	std::printf("C kernels:       %s\n", os_transform_isa());
+	
+	double t = time_it([&]{ c_fused(in, reference); });
+	std::printf("C fused:         %7.1f Mpoints/s\n", num_points / t / 1e6);
+	
+	t = time_it([&]{ c_batch(in, out); });
+	std::printf("C batch:         %7.1f Mpoints/s%s\n", num_points / t / 1e6
+	           , check(out, reference));
+	
+	t = time_it([&]{ convert<wgs84_to_national_grid>(in, out); });
+	std::printf("C++:             %7.1f Mpoints/s%s\n", num_points / t / 1e6
+	           , check(out, reference));
+	
+#ifdef __cpp_lib_execution
+	t = time_it([&]{ convert<wgs84_to_national_grid>(std::execution::par_unseq, in, out); });
+	std::printf("C++ (par_unseq): %7.1f Mpoints/s%s\n", num_points / t / 1e6
+	           , check(out, reference));
+#endif
+	
+	return 0;
+}
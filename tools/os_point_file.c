@@ -0,0 +1,236 @@
+/**
+ * A tool for writing, reading and benchmarking OS Coord point files (see
+ * os_coord_point_file.h) holding OS National Grid eastings and northings.
+ *
+ * Compilation (from this directory):
+ *   gcc -std=c99 -O2 -I.. ../os_coord_grid_square.c ../os_coord_ordinance_survey.c \
+ *       ../os_coord_point_file.c os_point_file.c -lm -o os_point_file
+ *
+ * Usage:
+ *   ./os_point_file write [file] [--grid-refs] < points.txt
+ *     Convert whitespace-separated "eastings northings height" lines read from
+ *     stdin into a point file.
+ *
+ *   ./os_point_file dump [file] [square]
+ *     Print the points in a file (optionally only those in one 100km square,
+ *     e.g. "TG") in the same text format.
+ *
+ *   ./os_point_file bench [file] [repeats]
+ *     Range-scan every 100km square of a memory-mapped file and report the
+ *     read throughput.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "os_coord.h"
+#include "os_coord_data.h"
+#include "os_coord_grid_square.h"
+#include "os_coord_ordinance_survey.h"
+#include "os_coord_point_file.h"
+
+
+static int
+write_file(const char *filename, int flags)
+{
+	// Read the points
+	size_t num_points = 0;
+	size_t capacity = 1024;
+	os_eas_nor_t *points = malloc(capacity * sizeof(os_eas_nor_t));
+	os_eas_nor_t point;
+	while (points && scanf("%lf %lf %lf", &point.e, &point.n, &point.h) == 3) {
+		if (num_points == capacity) {
+			capacity *= 2;
+			os_eas_nor_t *new_points = realloc(points, capacity * sizeof(os_eas_nor_t));
+			if (!new_points) {
+				free(points);
+				points = NULL;
+				break;
+			}
+			points = new_points;
+		}
+		points[num_points++] = point;
+	}
+	
+	// Group by 100km square
+	uint64_t *squares = malloc(num_points * sizeof(uint64_t) + 1);
+	size_t *permutation = malloc(num_points * sizeof(size_t) + 1);
+	uint64_t *scratch_squares = malloc(num_points * sizeof(uint64_t) + 1);
+	size_t *scratch_permutation = malloc(num_points * sizeof(size_t) + 1);
+	size_t size = os_point_file_size(num_points, OS_GR_NATIONAL_GRID, flags);
+	void *buffer = malloc(size);
+	if (!points || !squares || !permutation || !scratch_squares
+	    || !scratch_permutation || !buffer) {
+		fprintf(stderr, "Out of memory\n");
+		return -1;
+	}
+	os_grid_square_sort(points, num_points, OS_GR_NATIONAL_GRID, 100000,
+	                    squares, permutation,
+	                    scratch_squares, scratch_permutation);
+	
+	os_point_file_write(buffer, points, num_points, squares, permutation,
+	                    OS_TM_NATIONAL_GRID, OS_GR_NATIONAL_GRID, flags);
+	
+	FILE *f = fopen(filename, "wb");
+	if (!f || fwrite(buffer, 1, size, f) != size || fclose(f) != 0) {
+		perror(filename);
+		return -1;
+	}
+	
+	free(points);
+	free(squares);
+	free(permutation);
+	free(scratch_squares);
+	free(scratch_permutation);
+	free(buffer);
+	return 0;
+}
+
+
+/**
+ * Memory-map a point file. Returns 0 on success.
+ */
+static int
+map_file(const char *filename, os_point_file_t *file)
+{
+	int fd = open(filename, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		perror(filename);
+		return -1;
+	}
+	
+	void *buffer = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (buffer == MAP_FAILED) {
+		perror(filename);
+		return -1;
+	}
+	
+	if (!os_point_file_read(buffer, st.st_size, file)) {
+		fprintf(stderr, "%s: Not a valid point file\n", filename);
+		return -1;
+	}
+	
+	return 0;
+}
+
+
+static int
+dump_file(const char *filename, const char *code)
+{
+	os_point_file_t file;
+	if (map_file(filename, &file) != 0) {
+		return -1;
+	}
+	
+	size_t first = 0;
+	size_t num_points = file.num_points;
+	if (code) {
+		// The grid letters skip "I" and the conversion does not check its input
+		// (an "I" would be read as a "J") so reject anything else up front.
+		int valid = strlen(code) == (size_t)file.grid.num_digits;
+		for (size_t i = 0; valid && code[i] != '\0'; i++) {
+			valid = code[i] >= 'A' && code[i] <= 'Z' && code[i] != 'I';
+		}
+		
+		uint64_t square = file.num_squares;
+		if (valid) {
+			os_grid_ref_t grid_ref = {.e=0.0, .n=0.0, .h=0.0};
+			strncpy(grid_ref.code, code, sizeof(grid_ref.code) - 1);
+			os_eas_nor_t corner = os_grid_ref_to_eas_nor(grid_ref, file.grid);
+			square = os_eas_nor_to_grid_square(corner, file.grid, 100000);
+		}
+		if (square == file.num_squares) {
+			fprintf(stderr, "%s: Unknown grid square\n", code);
+			return -1;
+		}
+		os_point_file_square(&file, square, &first, &num_points);
+	}
+	
+	for (size_t i = first; i < first + num_points; i++) {
+		printf("%0.3f %0.3f %0.3f\n", file.e[i], file.n[i], file.h[i]);
+	}
+	
+	return 0;
+}
+
+
+static int
+bench_file(const char *filename, int repeats)
+{
+	os_point_file_t file;
+	if (map_file(filename, &file) != 0) {
+		return -1;
+	}
+	
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	
+	double sum = 0.0;
+	for (int r = 0; r < repeats; r++) {
+		for (uint64_t square = 0; square < file.num_squares; square++) {
+			size_t first, num_points;
+			os_point_file_square(&file, square, &first, &num_points);
+			for (size_t i = first; i < first + num_points; i++) {
+				sum += file.e[i] + file.n[i] + file.h[i];
+			}
+		}
+	}
+	
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (double)(end.tv_sec - start.tv_sec)
+	                 + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+	
+	// Points outside the grid are not scanned
+	size_t num_points = file.index[file.num_squares] * (size_t)repeats;
+	printf("%zu points in %0.3fs: %0.1f Mpoints/s, %0.1f MB/s (checksum %g)\n"
+	      , num_points
+	      , seconds
+	      , (double)num_points / seconds / 1e6
+	      , (double)(num_points * 3 * sizeof(double)) / seconds / 1e6
+	      , sum
+	      );
+	
+	return 0;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	if (argc >= 3 && argc <= 4 && strcmp(argv[1], "write") == 0) {
+		int flags = 0;
+		if (argc == 4) {
+			if (strcmp(argv[3], "--grid-refs") != 0) {
+				goto usage;
+			}
+			flags |= OS_POINT_FILE_GRID_REFS;
+		}
+		return write_file(argv[2], flags);
+	} else if (argc >= 3 && argc <= 4 && strcmp(argv[1], "dump") == 0) {
+		return dump_file(argv[2], (argc == 4) ? argv[3] : NULL);
+	} else if (argc >= 3 && argc <= 4 && strcmp(argv[1], "bench") == 0) {
+		int repeats = (argc == 4) ? atoi(argv[3]) : 10;
+		return bench_file(argv[2], (repeats > 0) ? repeats : 1);
+	}
+	
+usage:
+	fprintf(stderr, "%s: Usage %s write [file] [--grid-refs] < points.txt\n"
+	                "       %s dump [file] [square]\n"
+	                "       %s bench [file] [repeats]\n"
+	              , argv[0]
+	              , argv[0]
+	              , argv[0]
+	              , argv[0]
+	              );
+	return -1;
+}
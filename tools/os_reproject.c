@@ -0,0 +1,65 @@
+/**
+ * A tool which reprojects a (WGS84) GeoJSON document into OS National Grid
+ * eastings and northings in a single streaming pass.
+ *
+ * Compilation (from the top-level directory):
+ *   make tools
+ *
+ * Usage:
+ *   ./os_reproject < in.geojson > out.geojson
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "os_coord.h"
+#include "os_coord_data.h"
+#include "os_coord_geojson.h"
+
+/**
+ * Size of the chunks read from stdin.
+ */
+#define CHUNK_SIZE 65536
+
+
+static size_t
+write_stdout(void *context, const char *data, size_t length)
+{
+	return fwrite(data, 1, length, (FILE *)context);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	if (argc != 1) {
+		fprintf(stderr, "%s: Usage %s < in.geojson > out.geojson\n"
+		              , argv[0]
+		              , argv[0]
+		              );
+		return -1;
+	}
+	
+	// Too large to comfortably live on the stack
+	static os_geojson_reprojector_t reprojector;
+	os_geojson_reprojector_init(&reprojector,
+	                            OS_EL_WGS84, OS_HE_WGS84_TO_OSGB36,
+	                            OS_TM_NATIONAL_GRID,
+	                            write_stdout, stdout);
+	
+	static char chunk[CHUNK_SIZE];
+	size_t length;
+	while ((length = fread(chunk, 1, sizeof(chunk), stdin)) > 0) {
+		if (!os_geojson_reproject(&reprojector, chunk, length)) {
+			break;
+		}
+	}
+	
+	if (ferror(stdin) || !os_geojson_reproject_finish(&reprojector)
+	    || fflush(stdout) != 0) {
+		fprintf(stderr, "%s: Reprojection failed\n", argv[0]);
+		return -1;
+	}
+	
+	return 0;
+}